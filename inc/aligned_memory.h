@@ -26,8 +26,11 @@
  * \author cpapakonstantinou
  * \date 2021
  **/
+#include <cstring>
 #include <memory>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 /**
  * \brief   allocated a memory aligned array
@@ -116,4 +119,33 @@ std::shared_ptr<T[]> make_shared_aarray(size_t align, size_t size)
 	return std::shared_ptr<T[]>(palign<T>(align, size), &pdelete);
 }
 
+/// arrays of at least this many bytes get their zero pages mapped from the OS, like calloc
+static constexpr size_t zeroed_mmap_threshold = size_t(128) << 10;
+
+/**
+ * \brief 	declares a zero filled memory aligned shared_ptr array
+ * Large arrays are mapped anonymously: the OS hands out pages that read as zero and
+ * backs them with memory only when first touched, so untouched pages cost nothing.
+ * Small arrays, or alignments above the page size, are allocated with palign and cleared.
+ * \param 	align 	the byte alignment
+ * \param 	size 	the memory size
+ * \returns a shared_ptr array pointing at zero filled memory aligned address
+ */
+template<class T>
+std::shared_ptr<T[]> make_shared_zeroed(size_t align, size_t size)
+{
+	size_t bytes = size*sizeof(T);
+	if (bytes >= zeroed_mmap_threshold && align <= static_cast<size_t>(sysconf(_SC_PAGESIZE)))
+	{
+		void* ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED)
+			throw std::bad_alloc();
+		return std::shared_ptr<T[]>(static_cast<T*>(ptr), [bytes](T* p){ munmap(p, bytes); });
+	}
+
+	T* ptr = palign<T>(align, size);
+	std::memset(static_cast<void*>(ptr), 0, bytes);
+	return std::shared_ptr<T[]>(ptr, &pdelete);
+}
+
 #endif//__ALIGNED_MEMORY_H__
\ No newline at end of file
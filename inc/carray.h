@@ -25,10 +25,30 @@
  * \date 2025
  **/
 #include <cstdint>
+#include <exception>
 #include <numeric>
 #include <memory>
+#include <type_traits>
+#include <vector>
 #include <assert.h>
 #include <aligned_memory.h>
+#include <parallel.h>
+
+/// tag type selecting carray construction over an externally owned buffer
+struct carray_adopt_t { explicit carray_adopt_t() = default; };
+inline constexpr carray_adopt_t carray_adopt{};
+
+/// tag type selecting a buffer whose elements are left uninitialized, trivial types only
+struct carray_uninitialized_t { explicit carray_uninitialized_t() = default; };
+inline constexpr carray_uninitialized_t carray_uninitialized{};
+
+/// tag type selecting a value initialized buffer, backed by zero pages from the OS for trivial types
+struct carray_zeroed_t { explicit carray_zeroed_t() = default; };
+inline constexpr carray_zeroed_t carray_zeroed{};
+
+/// tag type selecting a buffer filled with copies of a value
+struct carray_fill_t { explicit carray_fill_t() = default; };
+inline constexpr carray_fill_t carray_fill{};
 
 /**
 * 	\brief	dynamically allocated and aligned contiguous memory arrays.
@@ -48,10 +68,12 @@ class carray
 		 *	\brief constructor.
 		 *	Variadic constructor which accepts a parameter pack.
 		 *	Parameter pack must expand to N elements.
+		 *	Trivial types are left uninitialized, other types are default constructed.
 		 * 
 		 *	\param 	ijk	parameter pack
 		 */
 		template<class... IJK>
+		requires (std::is_convertible_v<IJK, size_t> && ...)
 		explicit
 		carray(IJK&&... ijk):
 		_shape(new size_t[N]{ static_cast<size_t>(ijk)... })
@@ -60,6 +82,76 @@ class carray
 			allocate_memory();
 		}
 
+		/**
+		 *	\brief uninitialized constructor.
+		 *	The elements hold whatever the allocation held, nothing touches the buffer.
+		 *
+		 *	\param 	ijk	parameter pack of N extents
+		 */
+		template<class... IJK>
+		requires (std::is_convertible_v<IJK, size_t> && ...)
+		carray(carray_uninitialized_t, IJK&&... ijk):
+		_shape(new size_t[N]{ static_cast<size_t>(ijk)... })
+		{
+			static_assert(sizeof...(IJK) == N, "number of indices must match rank of array");
+			static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>,
+				"only trivial types can be left uninitialized");
+			allocate_memory();
+		}
+
+		/**
+		 *	\brief zeroed constructor.
+		 *	Trivial types get zero pages mapped from the OS, which cost nothing until touched.
+		 *	Other types are value initialized in parallel.
+		 *
+		 *	\param 	ijk	parameter pack of N extents
+		 */
+		template<class... IJK>
+		requires (std::is_convertible_v<IJK, size_t> && ...)
+		carray(carray_zeroed_t, IJK&&... ijk):
+		_shape(new size_t[N]{ static_cast<size_t>(ijk)... })
+		{
+			static_assert(sizeof...(IJK) == N, "number of indices must match rank of array");
+			if constexpr (std::is_trivial_v<T>)
+				_buffer = make_shared_zeroed<T>(A, size());
+			else
+				construct_memory([](T* first, T* last){ std::uninitialized_value_construct(first, last); });
+			index_memory();
+		}
+
+		/**
+		 *	\brief fill constructor.
+		 *	Every element is copy constructed from value, in parallel for large arrays.
+		 *
+		 *	\param 	value	value copied into every element
+		 *	\param 	ijk	parameter pack of N extents
+		 */
+		template<class... IJK>
+		requires (std::is_convertible_v<IJK, size_t> && ...)
+		carray(carray_fill_t, const T& value, IJK&&... ijk):
+		_shape(new size_t[N]{ static_cast<size_t>(ijk)... })
+		{
+			static_assert(sizeof...(IJK) == N, "number of indices must match rank of array");
+			construct_memory([&value](T* first, T* last){ std::uninitialized_fill(first, last, value); });
+			index_memory();
+		}
+
+		/**
+		 *	\brief adopting constructor.
+		 *	Builds the hierarchical pointers over memory carray did not allocate,
+		 *	e.g. a shared memory segment. The buffer's deleter releases the memory.
+		 *
+		 *	\param 	buffer	contiguous memory aligned to A holding the product of shape elements
+		 *	\param 	shape	extent of each of the N dimensions
+		 */
+		carray(carray_adopt_t, std::shared_ptr<T[]> buffer, const size_t* shape):
+		_shape(new size_t[N]),
+		_buffer(std::move(buffer))
+		{
+			std::copy(shape, shape + N, _shape.get());
+			index_memory();
+		}
+
 		/**	
 		*	\brief copy constructor.
 		*	Internally carray uses a shared_ptr to manage the buffer.
@@ -125,12 +217,77 @@ class carray
 		buffer_t _buffer; ///< contiguous memory of the carray
 		ptr_t _ptr; ///< Hierarchical pointer for structured memory access to buffer
 
+		/// bytes of elements each thread constructs or destroys
+		static constexpr size_t init_grain = size_t(1) << 20;
+
 		inline void
 		allocate_memory()
 		{
-			size_t n = std::accumulate(_shape.get(), _shape.get() + N, 1, std::multiplies<size_t>());
-			_buffer = make_shared_aarray<T>(A, n); 
+			if constexpr (std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>)
+			{
+				size_t n = size();
+				_buffer = make_shared_aarray<T>(A, n); 
+			}
+			else
+				construct_memory([](T* first, T* last){ std::uninitialized_default_construct(first, last); });
+			index_memory();
+		}
+
+		/// threads splitting the construction or destruction of n elements
+		static size_t
+		init_threads(size_t n)
+		{
+			return std::clamp<size_t>(n * sizeof(T) / init_grain, 1, default_threads());
+		}
+
+		/**
+		 *	\brief allocate _buffer and construct its elements in parallel chunks.
+		 *	Each thread constructs, and later destroys, one contiguous chunk, so pages are
+		 *	first touched by the thread that initializes them. If a constructor throws,
+		 *	the chunks already built are destroyed and the exception is rethrown.
+		 *	\param 	init	callable as init(T* first, T* last) constructing [first, last)
+		 */
+		template<class F>
+		void
+		construct_memory(F&& init)
+		{
+			size_t n = size(), threads = init_threads(n);
+			T* ptr = palign<T>(A, n);
+			auto chunk = [n, threads](size_t t){ return n * t / threads; };
+
+			std::vector<std::exception_ptr> errors(threads);
+			parallel_for(0, threads, [&](size_t first, size_t last){
+				for (size_t t = first; t < last; ++t)
+				{
+					try { init(ptr + chunk(t), ptr + chunk(t + 1)); }
+					catch (...) { errors[t] = std::current_exception(); }
+				}
+			}, threads);
+
+			for (size_t t = 0; t < threads; ++t)
+			{
+				if (!errors[t])
+					continue;
+				for (size_t u = 0; u < threads; ++u)
+					if (!errors[u])
+						std::destroy(ptr + chunk(u), ptr + chunk(u + 1));
+				pdelete(ptr);
+				std::rethrow_exception(errors[t]);
+			}
+
+			if constexpr (std::is_trivially_destructible_v<T>)
+				_buffer = buffer_t(ptr, &pdelete);
+			else
+				_buffer = buffer_t(ptr, [n, threads](T* p){
+					parallel_for(0, n, [p](size_t first, size_t last){ std::destroy(p + first, p + last); }, threads);
+					pdelete(p);
+				});
+		}
 
+		/**	\brief build the hierarchical pointer for row major access to _buffer */
+		inline void
+		index_memory()
+		{
 			if constexpr (N == 1)
 			{
 				 _ptr = std::shared_ptr<void>(_buffer.get(), [](void*){});
@@ -218,12 +375,40 @@ class carray
 	}
 
 	/**	\brief Range end operator. End of contiguous memory block. */
-	T* 
+	T*
 	end()
 	{
-		return _buffer.get() + std::accumulate(_shape.get(), _shape.get() + N, 1, std::multiplies<size_t>());
+		return _buffer.get() + size();
 	}
-	
+
+	/**	\brief Range begin operator. Read-only beginning of contiguous memory block. */
+	const T*
+	begin() const
+	{
+		return _buffer.get();
+	}
+
+	/**	\brief Range end operator. Read-only end of contiguous memory block. */
+	const T*
+	end() const
+	{
+		return _buffer.get() + size();
+	}
+
+	/**	\brief Extent of dimension i of the carray. */
+	size_t
+	shape(size_t i) const
+	{
+		return _shape[i];
+	}
+
+	/**	\brief Number of elements in the contiguous memory block. */
+	size_t
+	size() const
+	{
+		return std::accumulate(_shape.get(), _shape.get() + N, size_t(1), std::multiplies<size_t>());
+	}
+
 	/** \brief View acquisition. Acquire the hierarchical view (_ptr) for the buffer*/
 	decltype(auto)
 	get()
@@ -0,0 +1,442 @@
+#ifndef __C_BATCH_H__
+#define __C_BATCH_H__
+
+// Copyright (c) 2025  Constantine Papakonstantinou
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/**
+ * \file cbatch.h header only support for batches of small matrices in an interleaved (AoSoA) layout
+ * \author cpapakonstantinou
+ * \date 2025
+ **/
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <carray.h>
+#include <parallel.h>
+
+/**
+* 	\brief	batch of equally shaped small matrices stored in an interleaved layout.
+*	Problems are grouped by the number of lanes that fit in A bytes. Within a group
+*	element (i, j) of every problem is stored contiguously, so a loop over the lanes
+*	of a group vectorizes across problems:
+*	buffer[((group * rows + i) * cols + j) * lanes + lane]
+*	Lanes past the batch size in the last group hold the identity matrix.
+*	T - Type
+*	A - Alignment, also the byte width of a lane group
+*/
+template<class T, size_t A = 64>
+class cbatch
+{
+	static_assert(A % sizeof(T) == 0, "alignment must be a multiple of the element size");
+
+	public:
+		static constexpr size_t lanes = A / sizeof(T); ///< problems per interleaved group
+
+		/**
+		*	\brief	reference to one problem of the batch.
+		*	Strided view over the lane of the problem in its group.
+		*/
+		class reference
+		{
+			public:
+				reference(T* base, size_t cols):
+				_base(base),
+				_cols(cols)
+				{}
+
+				/**	\brief Element RW operator. */
+				T& operator()(size_t i, size_t j) const
+				{
+					return _base[(i * _cols + j) * lanes];
+				}
+
+			private:
+				T* _base; ///< element (0, 0) of the problem
+				size_t _cols; ///< columns of the problem
+		};
+
+		/**
+		 *	\brief constructor.
+		 *	\param 	batch	number of problems
+		 *	\param 	rows	rows of each problem
+		 *	\param 	cols	columns of each problem
+		 */
+		explicit
+		cbatch(size_t batch, size_t rows, size_t cols):
+		_batch(batch),
+		_rows(rows),
+		_cols(cols),
+		_buffer(std::max<size_t>(1, (batch + lanes - 1) / lanes * rows * cols * lanes))
+		{
+			if (batch % lanes)
+			{
+				T* last = group(groups() - 1);
+				for (size_t i = 0; i < rows; ++i)
+					for (size_t j = 0; j < cols; ++j)
+						std::fill(last + (i * cols + j) * lanes + batch % lanes, last + (i * cols + j + 1) * lanes, T(i == j));
+			}
+		}
+
+		/**	\brief Problem access. Returns a reference usable as batch(b)(i, j). */
+		reference
+		batch(size_t b)
+		{
+			return reference(group(b / lanes) + b % lanes, _cols);
+		}
+
+		/**	\brief Element RW operator. */
+		T& operator()(size_t b, size_t i, size_t j)
+		{
+			return group(b / lanes)[(i * _cols + j) * lanes + b % lanes];
+		}
+
+		/**	\brief Element RO operator. */
+		const T& operator()(size_t b, size_t i, size_t j) const
+		{
+			return group(b / lanes)[(i * _cols + j) * lanes + b % lanes];
+		}
+
+		/**	\brief First element of the interleaved group g. */
+		T*
+		group(size_t g)
+		{
+			return _buffer.begin() + g * _rows * _cols * lanes;
+		}
+
+		/**	\brief First element of the interleaved group g. Read-only. */
+		const T*
+		group(size_t g) const
+		{
+			return _buffer.begin() + g * _rows * _cols * lanes;
+		}
+
+		/**	\brief Range begin operator. Beginning of contiguous memory block. */
+		T* begin() { return _buffer.begin(); }
+
+		/**	\brief Range end operator. End of contiguous memory block. */
+		T* end() { return _buffer.end(); }
+
+		/**	\brief Number of problems. */
+		size_t size() const { return _batch; }
+
+		/**	\brief Number of interleaved groups. */
+		size_t groups() const { return (_batch + lanes - 1) / lanes; }
+
+		/**	\brief Rows of each problem. */
+		size_t rows() const { return _rows; }
+
+		/**	\brief Columns of each problem. */
+		size_t cols() const { return _cols; }
+
+	private:
+		size_t _batch; ///< number of problems
+		size_t _rows; ///< rows of each problem
+		size_t _cols; ///< columns of each problem
+		carray<T, 1, A> _buffer; ///< interleaved contiguous memory of the batch
+};
+
+/**
+*	\brief	one interleaved element of a group, the lanes of every problem in a single vector.
+*	Uses the GCC/Clang vector extensions so the batched kernels operate on whole
+*	lane groups without relying on the auto vectorizer to disprove aliasing.
+*/
+template<class T, size_t A>
+struct batch_lane
+{
+	typedef T vec __attribute__((vector_size(A)));
+};
+
+/**
+ * \brief   batched matrix product c(b) = a(b) * b(b) for every problem b
+ * \param   a       batch of m x k matrices
+ * \param   b       batch of k x n matrices
+ * \param   c       batch of m x n matrices, must not share memory with a or b
+ * \param   threads number of threads
+ */
+template<class T, size_t A>
+void
+batch_matmul(cbatch<T, A>& a, cbatch<T, A>& b, cbatch<T, A>& c, size_t threads = default_threads())
+{
+	using vec = typename batch_lane<T, A>::vec;
+	size_t m = a.rows(), k = a.cols(), n = b.cols();
+
+	if (b.rows() != k || c.rows() != m || c.cols() != n || a.size() != b.size() || a.size() != c.size())
+		throw std::invalid_argument("batch_matmul: batch shapes do not conform");
+
+	parallel_for(0, a.groups(), [&](size_t first, size_t last)
+	{
+		for (size_t g = first; g < last; ++g)
+		{
+			const vec* pa = reinterpret_cast<const vec*>(a.group(g));
+			const vec* pb = reinterpret_cast<const vec*>(b.group(g));
+			vec* pc = reinterpret_cast<vec*>(c.group(g));
+
+			for (size_t i = 0; i < m; ++i)
+				for (size_t j = 0; j < n; ++j)
+				{
+					vec acc = {};
+					for (size_t p = 0; p < k; ++p)
+						acc += pa[i * k + p] * pb[p * n + j];
+					pc[i * n + j] = acc;
+				}
+		}
+	}, threads);
+}
+
+/**
+ * \brief   swap lanes of two interleaved rows where the pivot of the lane selects row r
+ * \param   p       first row
+ * \param   q       second row
+ * \param   len     elements per row
+ * \param   swap    lane mask, non-zero where the rows are swapped
+ */
+template<class vec, class mask>
+static inline void
+batch_swap_rows(vec* p, vec* q, size_t len, const mask& swap)
+{
+	for (size_t c = 0; c < len; ++c)
+	{
+		vec u = p[c], v = q[c];
+		p[c] = swap ? v : u;
+		q[c] = swap ? u : v;
+	}
+}
+
+/**
+ * \brief   LU factorization with per lane partial pivoting of one interleaved group.
+ * Pivot rows are chosen independently for every lane and applied with selects so
+ * the elimination stays vectorized across the group. Singular lanes yield a zero
+ * determinant and non-finite solutions.
+ * \param   m       n x n matrices of the group, overwritten with the factors
+ * \param   n       order of the matrices
+ * \param   x       n x nrhs right hand sides, overwritten with the solutions, may be null
+ * \param   nrhs    number of right hand sides
+ * \param   det     determinant of each lane, may be null
+ */
+template<class T, size_t A>
+static void
+batch_lu_group(T* pm, size_t n, T* px, size_t nrhs, T* det)
+{
+	using vec = typename batch_lane<T, A>::vec;
+	vec* m = reinterpret_cast<vec*>(pm);
+	vec* x = reinterpret_cast<vec*>(px);
+	const vec zero = {};
+
+	vec sign = zero + T(1);
+
+	for (size_t k = 0; k < n; ++k)
+	{
+		vec best = m[k * n + k], piv = zero + T(k);
+		best = (best < zero) ? -best : best;
+
+		for (size_t r = k + 1; r < n; ++r)
+		{
+			vec a = m[r * n + k];
+			a = (a < zero) ? -a : a;
+			auto s = a > best;
+			best = s ? a : best;
+			piv = s ? zero + T(r) : piv;
+		}
+
+		for (size_t r = k + 1; r < n; ++r)
+		{
+			auto s = (piv == T(r));
+			batch_swap_rows(m + k * n, m + r * n, n, s);
+			if (x)
+				batch_swap_rows(x + k * nrhs, x + r * nrhs, nrhs, s);
+			sign = s ? -sign : sign;
+		}
+
+		vec d = m[k * n + k];
+		auto singular = (d == zero);
+		d = singular ? zero + T(1) : d;
+		for (size_t r = k + 1; r < n; ++r)
+		{
+			vec f = singular ? zero : m[r * n + k] / d;
+			for (size_t c = k + 1; c < n; ++c)
+				m[r * n + c] -= f * m[k * n + c];
+			for (size_t c = 0; x && c < nrhs; ++c)
+				x[r * nrhs + c] -= f * x[k * nrhs + c];
+		}
+	}
+
+	if (det)
+	{
+		for (size_t k = 0; k < n; ++k)
+			sign *= m[k * n + k];
+		*reinterpret_cast<vec*>(det) = sign;
+	}
+
+	for (size_t k = n; x && k-- > 0;)
+		for (size_t c = 0; c < nrhs; ++c)
+		{
+			vec y = x[k * nrhs + c];
+			for (size_t j = k + 1; j < n; ++j)
+				y -= m[k * n + j] * x[j * nrhs + c];
+			x[k * nrhs + c] = y / m[k * n + k];
+		}
+}
+
+/**
+ * \brief   Cholesky factorization and solve of one interleaved group of symmetric positive definite matrices
+ * \param   m       n x n matrices of the group, the lower triangle is overwritten with the factor
+ * \param   n       order of the matrices
+ * \param   x       n x nrhs right hand sides, overwritten with the solutions
+ * \param   nrhs    number of right hand sides
+ */
+template<class T, size_t A>
+static void
+batch_cholesky_group(T* pm, size_t n, T* px, size_t nrhs)
+{
+	using vec = typename batch_lane<T, A>::vec;
+	constexpr size_t L = A / sizeof(T);
+	vec* m = reinterpret_cast<vec*>(pm);
+	vec* x = reinterpret_cast<vec*>(px);
+
+	for (size_t j = 0; j < n; ++j)
+	{
+		vec d = m[j * n + j];
+		for (size_t p = 0; p < j; ++p)
+			d -= m[j * n + p] * m[j * n + p];
+		for (size_t l = 0; l < L; ++l)
+			d[l] = std::sqrt(d[l]);
+		m[j * n + j] = d;
+
+		vec inv = T(1) / d;
+		for (size_t i = j + 1; i < n; ++i)
+		{
+			vec e = m[i * n + j];
+			for (size_t p = 0; p < j; ++p)
+				e -= m[i * n + p] * m[j * n + p];
+			m[i * n + j] = e * inv;
+		}
+	}
+
+	for (size_t c = 0; c < nrhs; ++c)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			vec y = x[i * nrhs + c];
+			for (size_t p = 0; p < i; ++p)
+				y -= m[i * n + p] * x[p * nrhs + c];
+			x[i * nrhs + c] = y / m[i * n + i];
+		}
+
+		for (size_t i = n; i-- > 0;)
+		{
+			vec y = x[i * nrhs + c];
+			for (size_t p = i + 1; p < n; ++p)
+				y -= m[p * n + i] * x[p * nrhs + c];
+			x[i * nrhs + c] = y / m[i * n + i];
+		}
+	}
+}
+
+/**
+ * \brief   solve a(b) x(b) = rhs(b) for every problem with LU factorization and partial pivoting.
+ * a is left untouched, each thread factors a private copy of a group.
+ * \param   a       batch of n x n matrices
+ * \param   x       batch of n x nrhs right hand sides, overwritten with the solutions
+ * \param   threads number of threads
+ */
+template<class T, size_t A>
+void
+batch_lu_solve(cbatch<T, A>& a, cbatch<T, A>& x, size_t threads = default_threads())
+{
+	static_assert(std::is_floating_point_v<T>, "batch_lu_solve requires a floating point type");
+	constexpr size_t L = cbatch<T, A>::lanes;
+	size_t n = a.rows();
+
+	if (a.cols() != n || x.rows() != n || a.size() != x.size())
+		throw std::invalid_argument("batch_lu_solve: batch shapes do not conform");
+
+	parallel_for(0, a.groups(), [&](size_t first, size_t last)
+	{
+		auto m = make_unique_aarray<T>(A, n * n * L);
+		for (size_t g = first; g < last; ++g)
+		{
+			std::copy(a.group(g), a.group(g) + n * n * L, m.get());
+			batch_lu_group<T, A>(m.get(), n, x.group(g), x.cols(), nullptr);
+		}
+	}, threads);
+}
+
+/**
+ * \brief   solve a(b) x(b) = rhs(b) for every problem with a Cholesky factorization.
+ * a must be symmetric positive definite and is left untouched.
+ * \param   a       batch of n x n matrices
+ * \param   x       batch of n x nrhs right hand sides, overwritten with the solutions
+ * \param   threads number of threads
+ */
+template<class T, size_t A>
+void
+batch_cholesky_solve(cbatch<T, A>& a, cbatch<T, A>& x, size_t threads = default_threads())
+{
+	static_assert(std::is_floating_point_v<T>, "batch_cholesky_solve requires a floating point type");
+	constexpr size_t L = cbatch<T, A>::lanes;
+	size_t n = a.rows();
+
+	if (a.cols() != n || x.rows() != n || a.size() != x.size())
+		throw std::invalid_argument("batch_cholesky_solve: batch shapes do not conform");
+
+	parallel_for(0, a.groups(), [&](size_t first, size_t last)
+	{
+		auto m = make_unique_aarray<T>(A, n * n * L);
+		for (size_t g = first; g < last; ++g)
+		{
+			std::copy(a.group(g), a.group(g) + n * n * L, m.get());
+			batch_cholesky_group<T, A>(m.get(), n, x.group(g), x.cols());
+		}
+	}, threads);
+}
+
+/**
+ * \brief   determinant of every problem of the batch
+ * \param   a       batch of n x n matrices, left untouched
+ * \param   det     vector receiving one determinant per problem
+ * \param   threads number of threads
+ */
+template<class T, size_t A>
+void
+batch_det(cbatch<T, A>& a, carray<T, 1, A>& det, size_t threads = default_threads())
+{
+	static_assert(std::is_floating_point_v<T>, "batch_det requires a floating point type");
+	constexpr size_t L = cbatch<T, A>::lanes;
+	size_t n = a.rows();
+
+	if (a.cols() != n || det.shape(0) != a.size())
+		throw std::invalid_argument("batch_det: batch shapes do not conform");
+
+	parallel_for(0, a.groups(), [&](size_t first, size_t last)
+	{
+		auto m = make_unique_aarray<T>(A, n * n * L);
+		alignas(A) T d[L];
+		for (size_t g = first; g < last; ++g)
+		{
+			std::copy(a.group(g), a.group(g) + n * n * L, m.get());
+			batch_lu_group<T, A>(m.get(), n, nullptr, 0, d);
+			std::copy(d, d + std::min(L, a.size() - g * L), det.begin() + g * L);
+		}
+	}, threads);
+}
+
+#endif//__C_BATCH_H__
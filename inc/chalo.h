@@ -0,0 +1,455 @@
+#ifndef __C_HALO_H__
+#define __C_HALO_H__
+
+// Copyright (c) 2025  Constantine Papakonstantinou
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/**
+ * \file chalo.h header only support for ghost cell (halo) arrays and tiled stencil sweeps
+ * \author cpapakonstantinou
+ * \date 2025
+ **/
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <carray.h>
+#include <parallel.h>
+
+/// boundary condition used to fill the halo along one axis
+enum class halo_kind
+{
+	periodic, ///< the halo wraps around to the opposite side of the interior
+	dirichlet, ///< the halo holds a fixed value
+	copy ///< the halo repeats the nearest interior cell (zero gradient)
+};
+
+/**
+*	\brief	boundary conditions of a halo array, one kind per axis and the Dirichlet value.
+*	T - Type
+*/
+template<class T>
+struct halo_boundary
+{
+	std::array<halo_kind, 3> kind; ///< boundary condition of each axis
+	T value; ///< value of dirichlet halos
+
+	halo_boundary(halo_kind k, T v = T()):
+	kind{k, k, k},
+	value(v)
+	{}
+
+	halo_boundary(const std::array<halo_kind, 3>& k, T v = T()):
+	kind(k),
+	value(v)
+	{}
+};
+
+/**
+* 	\brief	3D array with a halo of ghost cells around its interior.
+*	Interior indices run over [0, n) on each axis, halo cells over [-h, 0) and [n, n + h).
+*	Rows along the last axis are padded so the first interior cell of every row is A aligned.
+*	T - Type
+*	A - Alignment
+*/
+template<class T, size_t A>
+class chalo
+{
+	static_assert(A % sizeof(T) == 0, "alignment must be a multiple of the element size");
+
+	public:
+		/**
+		 *	\brief constructor.
+		 *	\param 	n0		interior extent of axis 0
+		 *	\param 	n1		interior extent of axis 1
+		 *	\param 	n2		interior extent of axis 2, contiguous
+		 *	\param 	halo	width of the halo on every side
+		 */
+		explicit
+		chalo(size_t n0, size_t n1, size_t n2, size_t halo):
+		_shape{n0, n1, n2},
+		_halo(halo),
+		_sj(static_cast<ptrdiff_t>((n2 + 2 * halo + lanes - 1) / lanes * lanes)),
+		_si(_sj * static_cast<ptrdiff_t>(n1 + 2 * halo)),
+		_lead((lanes - halo % lanes) % lanes),
+		_buffer(_lead + static_cast<size_t>(_si) * (n0 + 2 * halo))
+		{}
+
+		/**	\brief Element RW operator, halo cells have negative or past the end indices. */
+		T& operator()(ptrdiff_t i, ptrdiff_t j, ptrdiff_t k)
+		{
+			return origin()[i * _si + j * _sj + k];
+		}
+
+		/**	\brief Element RO operator, halo cells have negative or past the end indices. */
+		const T& operator()(ptrdiff_t i, ptrdiff_t j, ptrdiff_t k) const
+		{
+			return origin()[i * _si + j * _sj + k];
+		}
+
+		/**	\brief First interior cell of row (i, j), A aligned. */
+		T*
+		row(ptrdiff_t i, ptrdiff_t j)
+		{
+			return origin() + i * _si + j * _sj;
+		}
+
+		/**	\brief Interior cell (0, 0, 0). */
+		T*
+		origin()
+		{
+			return _buffer.begin() + offset();
+		}
+
+		/**	\brief Interior cell (0, 0, 0). Read-only. */
+		const T*
+		origin() const
+		{
+			return _buffer.begin() + offset();
+		}
+
+		/**	\brief Element stride of axis d. */
+		ptrdiff_t
+		stride(size_t d) const
+		{
+			return d == 0 ? _si : (d == 1 ? _sj : 1);
+		}
+
+		/**	\brief Interior extent of axis d. */
+		size_t shape(size_t d) const { return _shape[d]; }
+
+		/**	\brief Width of the halo. */
+		size_t halo() const { return _halo; }
+
+		/**	\brief Range begin operator. Beginning of the padded memory block. */
+		T* begin() { return _buffer.begin(); }
+
+		/**	\brief Range end operator. End of the padded memory block. */
+		T* end() { return _buffer.end(); }
+
+		/**
+		 *	\brief	fill the halo from the interior.
+		 *	Axes are filled in the order 2, 1, 0 and each pass covers the halo of the
+		 *	previous ones, so edges and corners are consistent.
+		 *	\param 	bc		boundary conditions
+		 *	\param 	threads	number of threads
+		 */
+		void
+		fill_halo(const halo_boundary<T>& bc, size_t threads = default_threads())
+		{
+			ptrdiff_t h = _halo, n0 = _shape[0], n1 = _shape[1], n2 = _shape[2];
+
+			for (size_t d = 0; d < 3; ++d)
+				if (bc.kind[d] == halo_kind::periodic && _halo > _shape[d])
+					throw std::invalid_argument("fill_halo: periodic halo wider than the interior");
+
+			parallel_for(0, n0, [&](size_t first, size_t last){
+				for (ptrdiff_t i = first; i < static_cast<ptrdiff_t>(last); ++i)
+					for (ptrdiff_t j = 0; j < n1; ++j)
+					{
+						T* r = row(i, j);
+						for (ptrdiff_t g = 1; g <= h; ++g)
+						{
+							r[-g] = fill_value(bc, 2, r, -g, n2, 1);
+							r[n2 - 1 + g] = fill_value(bc, 2, r, n2 - 1 + g, n2, 1);
+						}
+					}
+			}, threads);
+
+			parallel_for(0, n0, [&](size_t first, size_t last){
+				for (ptrdiff_t i = first; i < static_cast<ptrdiff_t>(last); ++i)
+					for (ptrdiff_t g = 1; g <= h; ++g)
+					{
+						fill_row(bc, 1, row(i, -g) - h, row(i, source(bc.kind[1], -g, n1)) - h);
+						fill_row(bc, 1, row(i, n1 - 1 + g) - h, row(i, source(bc.kind[1], n1 - 1 + g, n1)) - h);
+					}
+			}, threads);
+
+			for (ptrdiff_t g = 1; g <= h; ++g)
+				parallel_for(0, n1 + 2 * h, [&](size_t first, size_t last){
+					for (ptrdiff_t j = static_cast<ptrdiff_t>(first) - h; j < static_cast<ptrdiff_t>(last) - h; ++j)
+					{
+						fill_row(bc, 0, row(-g, j) - h, row(source(bc.kind[0], -g, n0), j) - h);
+						fill_row(bc, 0, row(n0 - 1 + g, j) - h, row(source(bc.kind[0], n0 - 1 + g, n0), j) - h);
+					}
+				}, threads);
+		}
+
+		/**	\brief interior index a halo index x of an axis of extent n is filled from */
+		static ptrdiff_t
+		source(halo_kind kind, ptrdiff_t x, ptrdiff_t n)
+		{
+			if (kind == halo_kind::periodic)
+				return (x % n + n) % n;
+			return std::clamp<ptrdiff_t>(x, 0, n - 1);
+		}
+
+	private:
+		static constexpr size_t lanes = A / sizeof(T); ///< elements per alignment unit
+
+		std::array<size_t, 3> _shape; ///< interior extents
+		size_t _halo; ///< halo width
+		ptrdiff_t _sj; ///< stride of axis 1, padded row length
+		ptrdiff_t _si; ///< stride of axis 0
+		size_t _lead; ///< leading pad so that interior rows are aligned
+		carray<T, 1, A> _buffer; ///< padded contiguous memory
+
+		/**	\brief offset of interior cell (0, 0, 0) in the buffer */
+		size_t
+		offset() const
+		{
+			return _lead + static_cast<size_t>(_halo) * (_si + _sj + 1);
+		}
+
+		/**	\brief halo value at index x of a contiguous row r along axis d */
+		static T
+		fill_value(const halo_boundary<T>& bc, size_t d, const T* r, ptrdiff_t x, ptrdiff_t n, ptrdiff_t stride)
+		{
+			if (bc.kind[d] == halo_kind::dirichlet)
+				return bc.value;
+			return r[source(bc.kind[d], x, n) * stride];
+		}
+
+		/**	\brief fill a full padded row of the halo of axis d */
+		void
+		fill_row(const halo_boundary<T>& bc, size_t d, T* dst, const T* src)
+		{
+			if (bc.kind[d] == halo_kind::dirichlet)
+				std::fill(dst, dst + _shape[2] + 2 * _halo, bc.value);
+			else
+				std::copy(src, src + _shape[2] + 2 * _halo, dst);
+		}
+};
+
+/**
+*	\brief	tiling of a stencil sweep.
+*	tile is the interior block a thread updates at a time. fuse time steps are
+*	applied to a tile before moving on (temporal blocking), which needs a halo of
+*	at least fuse * radius cells.
+*/
+struct stencil_tiling
+{
+	std::array<size_t, 3> tile = {8, 16, 128}; ///< tile extents
+	size_t fuse = 1; ///< time steps fused per sweep
+	size_t threads = default_threads(); ///< number of threads
+};
+
+/**
+*	\brief	strided view of a 3D block whose base is global cell (o0, o1, o2).
+*	Lets a sweep address a halo array and a per thread scratch block with global indices.
+*/
+template<class T>
+struct stencil_view
+{
+	T* base; ///< cell (o[0], o[1], o[2])
+	ptrdiff_t si, sj; ///< strides of axis 0 and 1
+	std::array<ptrdiff_t, 3> o; ///< global index of base
+
+	T*
+	at(ptrdiff_t i, ptrdiff_t j, ptrdiff_t k) const
+	{
+		return base + (i - o[0]) * si + (j - o[1]) * sj + (k - o[2]);
+	}
+};
+
+/**
+ * \brief   apply the point kernel over the global block [lo, hi), rows along axis 2 are contiguous
+ * and the loop over them vectorizes when f inlines.
+ */
+template<class T, class F>
+static inline void
+stencil_block(const stencil_view<T>& src, const stencil_view<T>& dst,
+	const std::array<ptrdiff_t, 3>& lo, const std::array<ptrdiff_t, 3>& hi, F& f)
+{
+	for (ptrdiff_t i = lo[0]; i < hi[0]; ++i)
+		for (ptrdiff_t j = lo[1]; j < hi[1]; ++j)
+		{
+			const T* s = src.at(i, j, lo[2]);
+			T* d = dst.at(i, j, lo[2]);
+			for (ptrdiff_t k = 0; k < hi[2] - lo[2]; ++k)
+				d[k] = f(s + k, src.sj, src.si);
+		}
+}
+
+/**
+ * \brief   re-apply the boundary conditions to the cells of [lo, hi) outside the interior n.
+ * Cells outside along a dirichlet axis take the value, cells outside along copy axes
+ * take the (already computed) cell at the clamped index, periodic axes keep their computed value.
+ */
+template<class T>
+static inline void
+stencil_boundary(const stencil_view<T>& v, const std::array<ptrdiff_t, 3>& lo, const std::array<ptrdiff_t, 3>& hi,
+	const std::array<ptrdiff_t, 3>& n, const halo_boundary<T>& bc)
+{
+	auto outside = [&](size_t d, ptrdiff_t x){ return bc.kind[d] != halo_kind::periodic && (x < 0 || x >= n[d]); };
+	auto clamp = [&](size_t d, ptrdiff_t x){ return bc.kind[d] == halo_kind::copy ? std::clamp<ptrdiff_t>(x, 0, n[d] - 1) : x; };
+	auto apply = [&](ptrdiff_t i, ptrdiff_t j, ptrdiff_t k)
+	{
+		bool oi = outside(0, i), oj = outside(1, j), ok = outside(2, k);
+		if ((oi && bc.kind[0] == halo_kind::dirichlet) || (oj && bc.kind[1] == halo_kind::dirichlet)
+			|| (ok && bc.kind[2] == halo_kind::dirichlet))
+			*v.at(i, j, k) = bc.value;
+		else
+			*v.at(i, j, k) = *v.at(clamp(0, i), clamp(1, j), clamp(2, k));
+	};
+
+	for (ptrdiff_t i = lo[0]; i < hi[0]; ++i)
+		for (ptrdiff_t j = lo[1]; j < hi[1]; ++j)
+		{
+			if (outside(0, i) || outside(1, j))
+			{
+				for (ptrdiff_t k = lo[2]; k < hi[2]; ++k)
+					apply(i, j, k);
+			}
+			else if (bc.kind[2] != halo_kind::periodic)
+			{
+				for (ptrdiff_t k = lo[2]; k < std::min<ptrdiff_t>(hi[2], 0); ++k)
+					apply(i, j, k);
+				for (ptrdiff_t k = std::max(lo[2], n[2]); k < hi[2]; ++k)
+					apply(i, j, k);
+			}
+		}
+}
+
+/**
+ * \brief   one sweep of s fused time steps from src to dst. The halo of src must be filled.
+ * With s == 1 tiles are updated directly. Otherwise each tile is loaded with a ghost zone
+ * of s * radius cells into per thread scratch, advanced s steps on a shrinking region with
+ * the boundary conditions re-applied between steps, and its interior written to dst.
+ */
+template<class T, size_t A, class F>
+static void
+stencil_sweep(chalo<T, A>& src, chalo<T, A>& dst, F& f, size_t radius, size_t s,
+	const halo_boundary<T>& bc, const stencil_tiling& tiling)
+{
+	std::array<ptrdiff_t, 3> n, t, nt;
+	for (size_t d = 0; d < 3; ++d)
+	{
+		n[d] = src.shape(d);
+		t[d] = std::max<size_t>(1, tiling.tile[d]);
+		nt[d] = (n[d] + t[d] - 1) / t[d];
+	}
+
+	stencil_view<T> vs{src.origin(), src.stride(0), src.stride(1), {0, 0, 0}};
+	stencil_view<T> vd{dst.origin(), dst.stride(0), dst.stride(1), {0, 0, 0}};
+	ptrdiff_t e = static_cast<ptrdiff_t>(s * radius);
+	constexpr size_t lanes = A / sizeof(T);
+
+	parallel_for(0, nt[0] * nt[1] * nt[2], [&](size_t first, size_t last)
+	{
+		std::array<ptrdiff_t, 3> ext;
+		for (size_t d = 0; d < 3; ++d)
+			ext[d] = std::min(t[d], n[d]) + 2 * e;
+		ptrdiff_t sj = (ext[2] + lanes - 1) / lanes * lanes, si = sj * ext[1];
+		size_t scratch = (s > 1) ? static_cast<size_t>(si * ext[0]) : 0;
+		auto b0 = make_unique_aarray<T>(A, std::max<size_t>(1, scratch));
+		auto b1 = make_unique_aarray<T>(A, std::max<size_t>(1, scratch));
+
+		for (size_t tile = first; tile < last; ++tile)
+		{
+			std::array<ptrdiff_t, 3> lo, hi;
+			size_t idx[3] = { tile / (nt[1] * nt[2]), tile / nt[2] % nt[1], tile % nt[2] };
+			for (size_t d = 0; d < 3; ++d)
+			{
+				lo[d] = idx[d] * t[d];
+				hi[d] = std::min(lo[d] + t[d], n[d]);
+			}
+
+			if (s == 1)
+			{
+				stencil_block(vs, vd, lo, hi, f);
+				continue;
+			}
+
+			std::array<ptrdiff_t, 3> origin = {lo[0] - e, lo[1] - e, lo[2] - e};
+			stencil_view<T> v0{b0.get(), si, sj, origin}, v1{b1.get(), si, sj, origin};
+
+			for (ptrdiff_t i = lo[0] - e; i < hi[0] + e; ++i)
+				for (ptrdiff_t j = lo[1] - e; j < hi[1] + e; ++j)
+					std::copy(vs.at(i, j, lo[2] - e), vs.at(i, j, hi[2] + e), v0.at(i, j, lo[2] - e));
+
+			bool boundary = false;
+			for (size_t d = 0; d < 3; ++d)
+				boundary |= (bc.kind[d] != halo_kind::periodic) && (lo[d] - e < 0 || hi[d] + e > n[d]);
+
+			for (size_t m = 1; m <= s; ++m)
+			{
+				ptrdiff_t em = e - static_cast<ptrdiff_t>(m * radius);
+				std::array<ptrdiff_t, 3> rlo = {lo[0] - em, lo[1] - em, lo[2] - em};
+				std::array<ptrdiff_t, 3> rhi = {hi[0] + em, hi[1] + em, hi[2] + em};
+
+				if (m == s)
+					stencil_block(v0, vd, rlo, rhi, f);
+				else
+				{
+					stencil_block(v0, v1, rlo, rhi, f);
+					if (boundary)
+						stencil_boundary(v1, rlo, rhi, n, bc);
+					std::swap(v0, v1);
+				}
+			}
+		}
+	}, tiling.threads);
+}
+
+/**
+ * \brief   advance a halo array by a number of time steps of an explicit stencil.
+ * The point kernel is called as f(const T* c, ptrdiff_t sj, ptrdiff_t si) and returns the new
+ * value of the cell c points at, its neighbours are c[+-1] along axis 2, c[+-sj] along axis 1
+ * and c[+-si] along axis 0. The domain is tiled, tiles run in parallel, and tiling.fuse steps
+ * are applied per tile (temporal blocking) before the halo is refilled.
+ * \param   u       halo array, interior updated in place, halo width >= radius * tiling.fuse
+ * \param   f       point kernel
+ * \param   radius  reach of the stencil in cells
+ * \param   steps   number of time steps
+ * \param   bc      boundary conditions
+ * \param   tiling  tile extents, fused steps and threads
+ */
+template<class T, size_t A, class F>
+void
+stencil(chalo<T, A>& u, F&& f, size_t radius, size_t steps, const std::type_identity_t<halo_boundary<T>>& bc,
+	const stencil_tiling& tiling = {})
+{
+	size_t fuse = std::max<size_t>(1, tiling.fuse);
+	if (u.halo() < radius * fuse)
+		throw std::invalid_argument("stencil: halo narrower than radius * fused steps");
+	if (steps == 0)
+		return;
+
+	chalo<T, A> v(u.shape(0), u.shape(1), u.shape(2), u.halo());
+	chalo<T, A>* src = &u;
+	chalo<T, A>* dst = &v;
+
+	src->fill_halo(bc, tiling.threads);
+	while (steps)
+	{
+		size_t s = std::min(fuse, steps);
+		stencil_sweep(*src, *dst, f, radius, s, bc, tiling);
+		dst->fill_halo(bc, tiling.threads);
+		std::swap(src, dst);
+		steps -= s;
+	}
+
+	if (src != &u)
+		std::copy(src->begin(), src->end(), u.begin());
+}
+
+#endif//__C_HALO_H__
@@ -0,0 +1,316 @@
+#ifndef __C_SHARED_H__
+#define __C_SHARED_H__
+
+// Copyright (c) 2025  Constantine Papakonstantinou
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/**
+ * \file cshared.h header only support for carrays in named POSIX shared memory
+ * \author cpapakonstantinou
+ * \date 2025
+ **/
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <carray.h>
+
+/**
+*	\brief	header at the start of a shared memory segment.
+*	Describes the array so another process can attach by name, and carries
+*	the sequence counter of the seqlock guarding the frame.
+*/
+struct cshared_header
+{
+	static constexpr uint64_t signature = 0x3179617272616373ull; ///< "scarray1"
+
+	uint64_t magic; ///< signature, written last on creation
+	uint64_t rank; ///< rank of the array
+	uint64_t element; ///< sizeof the element type
+	uint64_t align; ///< alignment of the buffer
+	uint64_t offset; ///< byte offset of the buffer from the start of the segment
+	size_t shape[4]; ///< extent of each dimension
+	std::atomic<uint64_t> sequence; ///< seqlock sequence, odd while a frame is written
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory seqlock requires lock free 64 bit atomics");
+
+/**
+* 	\brief	carray placed in a named POSIX shared memory segment.
+*	The producer creates the segment, consumers attach to it by name and rebuild
+*	their local pointer tables over the shared buffer. Frames are published with
+*	a single writer seqlock: the writer makes the sequence odd while it writes, and
+*	a reader accepts a copy only if the sequence was even and unchanged around it.
+*	The generation of a frame is the number of completed writes.
+*	T - Type, must be trivially copyable
+*	N - Rank
+*	A - Alignment, at most the page size
+*/
+template<class T, size_t N, size_t A>
+class cshared
+{
+	static_assert(std::is_trivially_copyable_v<T>, "shared memory carrays require a trivially copyable type");
+
+	public:
+		/**
+		 *	\brief	create (or replace) the named segment and map it.
+		 *	An existing segment of the same name is unlinked rather than truncated, so
+		 *	processes still attached to it keep their mapping intact, while later
+		 *	attachers get the new segment.
+		 *	\param 	name	POSIX shared memory name, e.g. "/frames"
+		 *	\param 	ijk		shape of the array, N extents
+		 *	\returns the mapped shared carray
+		 */
+		template<class... IJK>
+		static cshared<T, N, A>
+		create(const std::string& name, IJK... ijk)
+		{
+			static_assert(sizeof...(IJK) == N, "number of indices must match rank of array");
+
+			size_t shape[N] = { static_cast<size_t>(ijk)... };
+			size_t n = std::accumulate(shape, shape + N, size_t(1), std::multiplies<size_t>());
+			size_t offset = (sizeof(cshared_header) + A - 1) / A * A;
+			size_t bytes = offset + n * sizeof(T);
+
+			check_alignment();
+
+			shm_unlink(name.c_str());
+			int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+			if (fd < 0)
+				throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+			if (ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+			{
+				int err = errno;
+				close(fd);
+				shm_unlink(name.c_str());
+				throw std::system_error(err, std::generic_category(), "ftruncate " + name);
+			}
+
+			auto mapping = map(fd, bytes, name);
+			auto header = new (mapping.get()) cshared_header{};
+			header->rank = N;
+			header->element = sizeof(T);
+			header->align = A;
+			header->offset = offset;
+			std::copy(shape, shape + N, header->shape);
+			header->sequence.store(0, std::memory_order_relaxed);
+			std::atomic_ref<uint64_t>(header->magic).store(cshared_header::signature, std::memory_order_release);
+
+			return cshared<T, N, A>(std::move(mapping), name);
+		}
+
+		/**
+		 *	\brief	attach to an existing segment created by cshared::create.
+		 *	\param 	name	POSIX shared memory name
+		 *	\returns the mapped shared carray with local pointer tables
+		 */
+		static cshared<T, N, A>
+		attach(const std::string& name)
+		{
+			check_alignment();
+
+			int fd = shm_open(name.c_str(), O_RDWR, 0);
+			if (fd < 0)
+				throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+
+			struct stat st;
+			if (fstat(fd, &st) != 0)
+			{
+				int err = errno;
+				close(fd);
+				throw std::system_error(err, std::generic_category(), "fstat " + name);
+			}
+			size_t bytes = static_cast<size_t>(st.st_size);
+			if (bytes < sizeof(cshared_header))
+			{
+				close(fd);
+				throw std::runtime_error("cshared: segment " + name + " is too small");
+			}
+
+			auto mapping = map(fd, bytes, name);
+			auto header = static_cast<cshared_header*>(mapping.get());
+
+			if (std::atomic_ref<uint64_t>(header->magic).load(std::memory_order_acquire) != cshared_header::signature)
+				throw std::runtime_error("cshared: segment " + name + " is not an initialized carray");
+			if (header->rank != N || header->element != sizeof(T) || header->offset % A != 0)
+				throw std::runtime_error("cshared: segment " + name + " does not match the requested carray type");
+
+			size_t n = std::accumulate(header->shape, header->shape + N, size_t(1), std::multiplies<size_t>());
+			if (header->offset + n * sizeof(T) > bytes)
+				throw std::runtime_error("cshared: segment " + name + " is smaller than its shape");
+
+			return cshared<T, N, A>(std::move(mapping), name);
+		}
+
+		/**	\brief remove the name of a segment, mappings stay valid until released */
+		static void
+		unlink(const std::string& name)
+		{
+			if (shm_unlink(name.c_str()) != 0 && errno != ENOENT)
+				throw std::system_error(errno, std::generic_category(), "shm_unlink " + name);
+		}
+
+		/**	\brief The shared carray, valid as long as any copy of it or of this handle exists. */
+		carray<T, N, A>&
+		array()
+		{
+			return _array;
+		}
+
+		/**	\brief Name of the segment. */
+		const std::string&
+		name() const
+		{
+			return _name;
+		}
+
+		/**	\brief Number of frames published so far. */
+		uint64_t
+		generation() const
+		{
+			return sequence().load(std::memory_order_acquire) / 2;
+		}
+
+		/**	\brief Start writing a frame. Single writer only. */
+		void
+		begin_write()
+		{
+			auto& seq = sequence();
+			seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+
+		/**	\brief Publish the frame written since begin_write. */
+		void
+		end_write()
+		{
+			auto& seq = sequence();
+			seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		/**
+		 *	\brief	write a frame, f(carray&) fills the shared buffer
+		 *	\returns the generation of the published frame
+		 */
+		template<class F>
+		uint64_t
+		write(F&& f)
+		{
+			begin_write();
+			f(_array);
+			end_write();
+			return generation();
+		}
+
+		/**
+		 *	\brief	try once to read a consistent frame, f(carray&) copies what it needs out of the shared buffer.
+		 *	\param 	f			reader, its result must be discarded when try_read fails
+		 *	\param 	generation	generation of the frame f observed
+		 *	\returns true if no write overlapped f
+		 */
+		template<class F>
+		bool
+		try_read(F&& f, uint64_t& generation)
+		{
+			auto& seq = sequence();
+			uint64_t s0 = seq.load(std::memory_order_acquire);
+			if (s0 & 1)
+				return false;
+			f(_array);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			generation = s0 / 2;
+			return seq.load(std::memory_order_relaxed) == s0;
+		}
+
+		/**
+		 *	\brief	read a consistent frame, retrying while a write overlaps f
+		 *	\returns the generation of the frame f observed
+		 */
+		template<class F>
+		uint64_t
+		read(F&& f)
+		{
+			uint64_t generation;
+			while (!try_read(f, generation))
+				std::this_thread::yield();
+			return generation;
+		}
+
+	private:
+		std::shared_ptr<void> _mapping; ///< mapped segment, unmapped with the last reference
+		std::string _name; ///< name of the segment
+		carray<T, N, A> _array; ///< carray over the shared buffer with local pointer tables
+
+		cshared(std::shared_ptr<void> mapping, const std::string& name):
+		_mapping(mapping),
+		_name(name),
+		_array(carray_adopt, buffer(mapping), header(mapping)->shape)
+		{}
+
+		static cshared_header*
+		header(const std::shared_ptr<void>& mapping)
+		{
+			return static_cast<cshared_header*>(mapping.get());
+		}
+
+		/**	\brief aliasing shared_ptr to the buffer, keeps the mapping alive */
+		static std::shared_ptr<T[]>
+		buffer(const std::shared_ptr<void>& mapping)
+		{
+			auto base = static_cast<unsigned char*>(mapping.get());
+			return std::shared_ptr<T[]>(mapping, reinterpret_cast<T*>(base + header(mapping)->offset));
+		}
+
+		std::atomic<uint64_t>&
+		sequence() const
+		{
+			return header(_mapping)->sequence;
+		}
+
+		static void
+		check_alignment()
+		{
+			if (A > static_cast<size_t>(sysconf(_SC_PAGESIZE)))
+				throw std::invalid_argument("cshared: alignment larger than the page size");
+		}
+
+		/**	\brief map a segment and close its descriptor */
+		static std::shared_ptr<void>
+		map(int fd, size_t bytes, const std::string& name)
+		{
+			void* addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			int err = errno;
+			close(fd);
+			if (addr == MAP_FAILED)
+				throw std::system_error(err, std::generic_category(), "mmap " + name);
+			return std::shared_ptr<void>(addr, [bytes](void* p){ munmap(p, bytes); });
+		}
+};
+
+#endif//__C_SHARED_H__
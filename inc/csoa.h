@@ -0,0 +1,247 @@
+#ifndef __C_SOA_H__
+#define __C_SOA_H__
+
+// Copyright (c) 2025  Constantine Papakonstantinou
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/**
+ * \file csoa.h header only support for structure of arrays storage of record types
+ * \author cpapakonstantinou
+ * \date 2025
+ **/
+#include <algorithm>
+#include <numeric>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <aligned_memory.h>
+
+/**
+ *  Field wrappers a record template is instantiated with.
+ *  A record is declared once as a template over the wrapper, and lists its fields in tie():
+ *
+ *  template<template<class> class F>
+ *  struct particle
+ *  {
+ *      F<float> x, y, z;
+ *      F<double> m;
+ *      auto tie() { return std::tie(x, y, z, m); }
+ *  };
+ */
+template<class T> using soa_value = T; ///< record holding values
+template<class T> using soa_ref = T&; ///< record referencing one element of every field
+template<class T> using soa_ptr = T*; ///< record pointing at the buffer of every field
+template<class T> using soa_span = std::span<T>; ///< record viewing the buffer of every field
+
+/// true if every field of a tie() tuple can live in raw memory that is never constructed or destroyed
+template<class Tie> struct soa_trivial_fields;
+template<class... T>
+struct soa_trivial_fields<std::tuple<T...>> : std::bool_constant<(
+	(std::is_trivially_default_constructible_v<std::remove_reference_t<T>> &&
+	 std::is_trivially_destructible_v<std::remove_reference_t<T>>) && ...)> {};
+
+/**
+* 	\brief	dynamically allocated structure of arrays for record types.
+*	Every field of the record is stored in its own contiguous, A aligned, buffer.
+*	All field buffers live in a single allocation. Elements are indexed row major
+*	like a carray and accessed through a proxy record of references, p[i].x.
+*	Field buffers are raw memory, so every field type must be trivial to construct and destroy.
+*	R - Record template
+*	N - Rank
+*	A - Alignment
+*/
+template<template<template<class> class> class R, size_t N, size_t A>
+class csoa
+{
+	static_assert(N >= 1 && N <= 4, "csoa supports rank <= 4");
+
+	public:
+		using value_type = R<soa_value>; ///< record of values
+		using reference = R<soa_ref>; ///< record of references to one element
+		using pointers = R<soa_ptr>; ///< record of pointers to the field buffers
+		using columns_type = R<soa_span>; ///< record of views over the field buffers
+
+		///	number of fields of the record
+		static constexpr size_t fields = std::tuple_size_v<decltype(std::declval<pointers&>().tie())>;
+
+		static_assert(soa_trivial_fields<decltype(std::declval<value_type&>().tie())>::value,
+			"csoa fields must be trivially default constructible and trivially destructible");
+
+		/**
+		 *	\brief constructor.
+		 *	Variadic constructor which accepts a parameter pack.
+		 *	Parameter pack must expand to N elements.
+		 *
+		 *	\param 	ijk	parameter pack
+		 */
+		template<class... IJK>
+		explicit
+		csoa(IJK&&... ijk):
+		_shape(new size_t[N]{ static_cast<size_t>(ijk)... })
+		{
+			static_assert(sizeof...(IJK) == N, "number of indices must match rank of array");
+			allocate_memory();
+		}
+
+		/**
+		*	\brief copy constructor.
+		*	The field buffers are shared between copies.
+		*	\param 	an initialized csoa class
+		*/
+		csoa(csoa<R, N, A>& a):
+		_shape(a._shape),
+		_buffer(a._buffer),
+		_ptr(a._ptr)
+		{}
+
+		/**	\brief	move constructor. */
+		csoa(csoa<R, N, A>&& a) noexcept:
+		_shape(std::move(a._shape)),
+		_buffer(std::move(a._buffer)),
+		_ptr(a._ptr)
+		{}
+
+		/**	\brief	Copy assignment operator. */
+		csoa<R, N, A>&
+		operator=(const csoa<R, N, A>& a) = default;
+
+		/**	\brief	Move assignment operator. */
+		csoa<R, N, A>&
+		operator=(csoa<R, N, A>&& a) noexcept = default;
+
+	private:
+
+		using shape_t = std::shared_ptr<size_t[]>; ///< shared array shape datatype
+		using buffer_t = std::shared_ptr<unsigned char[]>; ///< single allocation holding every field buffer
+
+		shape_t _shape; ///< shape of the csoa
+		buffer_t _buffer; ///< contiguous memory of all fields
+		pointers _ptr{}; ///< first element of every field buffer
+
+		/**	\brief round a byte offset up to the alignment */
+		static constexpr size_t
+		align_up(size_t bytes)
+		{
+			return (bytes + A - 1) / A * A;
+		}
+
+		inline void
+		allocate_memory()
+		{
+			size_t n = size(), bytes = 0;
+			auto field_ptrs = _ptr.tie();
+
+			std::apply([&](auto&... p){ ((bytes = align_up(bytes) + n * sizeof(*p)), ...); }, field_ptrs);
+			_buffer = make_shared_aarray<unsigned char>(A, align_up(std::max<size_t>(bytes, 1)));
+
+			size_t offset = 0;
+			std::apply([&](auto&... p){
+				((offset = align_up(offset),
+				  p = reinterpret_cast<std::remove_reference_t<decltype(p)>>(_buffer.get() + offset),
+				  offset += n * sizeof(*p)), ...);
+			}, field_ptrs);
+		}
+
+		/**	\brief row major linear index of a multi index */
+		template<class... IJK>
+		size_t
+		linear(IJK... ijk) const
+		{
+			size_t idx[] = { static_cast<size_t>(ijk)... }, l = 0;
+			for (size_t d = 0; d < N; ++d)
+				l = l * _shape[d] + idx[d];
+			return l;
+		}
+
+	public:
+	/**	\brief Element RW operator. Returns a proxy record referencing element i. */
+	template<typename... IJK>
+	reference operator()(IJK... ijk)
+	{
+		static_assert(sizeof...(IJK) == N, "number of indices must match rank of array");
+		return (*this)[linear(ijk...)];
+	}
+
+	/**	\brief Linear RW operator. Returns a proxy record referencing element i of the contiguous fields. */
+	reference operator[](size_t i)
+	{
+		return std::apply([i](auto... p){ return reference{ p[i]... }; }, _ptr.tie());
+	}
+
+	/**	\brief Read a copy of element i as a record of values. */
+	value_type
+	get(size_t i) const
+	{
+		pointers p = _ptr;
+		return std::apply([i](auto... q){ return value_type{ q[i]... }; }, p.tie());
+	}
+
+	/**	\brief Write the record of values v to element i. */
+	void
+	set(size_t i, value_type v)
+	{
+		auto src = v.tie();
+		auto dst = _ptr.tie();
+		[&]<size_t... F>(std::index_sequence<F...>){
+			((std::get<F>(dst)[i] = std::get<F>(src)), ...);
+		}(std::make_index_sequence<fields>{});
+	}
+
+	/**	\brief Contiguous, A aligned view of field F. */
+	template<size_t F>
+	auto
+	field()
+	{
+		return std::span(std::get<F>(_ptr.tie()), size());
+	}
+
+	/**	\brief Record of contiguous views over every field, c.x[i]. */
+	columns_type
+	columns()
+	{
+		size_t n = size();
+		return std::apply([n](auto... p){ return columns_type{ std::span(p, n)... }; }, _ptr.tie());
+	}
+
+	/**	\brief Record of pointers to the first element of every field. */
+	pointers
+	data() const
+	{
+		return _ptr;
+	}
+
+	/**	\brief Extent of dimension i of the csoa. */
+	size_t
+	shape(size_t i) const
+	{
+		return _shape[i];
+	}
+
+	/**	\brief Number of records. */
+	size_t
+	size() const
+	{
+		return std::accumulate(_shape.get(), _shape.get() + N, size_t(1), std::multiplies<size_t>());
+	}
+};
+
+#endif//__C_SOA_H__
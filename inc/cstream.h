@@ -0,0 +1,879 @@
+#ifndef __C_STREAM_H__
+#define __C_STREAM_H__
+
+// Copyright (c) 2025  Constantine Papakonstantinou
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+/**
+ * \file cstream.h header only support for streaming carrays from disk asynchronously
+ * \author cpapakonstantinou
+ * \date 2025
+ **/
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <carray.h>
+
+#if defined(__linux__) && defined(__NR_io_uring_setup) && __has_include(<linux/io_uring.h>)
+	#include <linux/io_uring.h>
+	#define CSTREAM_URING 1
+#else
+	#define CSTREAM_URING 0
+#endif
+
+/// read backend of a cstream
+enum class stream_backend
+{
+	automatic, ///< io_uring when the kernel provides it, the thread pool otherwise
+	uring, ///< io_uring submission and completion rings
+	threads ///< pool of threads issuing blocking pread
+};
+
+/// configuration of a cstream
+struct stream_options
+{
+	size_t buffers = 2; ///< arrays owned by the stream, 2 for double and 3 for triple buffering
+	stream_backend backend = stream_backend::automatic; ///< read backend
+	size_t chunk = size_t(1) << 20; ///< bytes per read request
+	size_t depth = 32; ///< io_uring requests in flight
+	size_t threads = 4; ///< workers of the thread pool backend
+};
+
+/// progress of a cstream
+struct stream_stats
+{
+	const char* backend; ///< name of the read backend
+	size_t arrays; ///< arrays delivered to the consumer
+	size_t bytes; ///< bytes delivered to the consumer
+	double seconds; ///< time from construction to the last delivery
+	double stalled; ///< time the consumer waited for reads
+	size_t max_depth; ///< largest number of read requests queued or in flight
+	double mean_depth; ///< mean number of read requests queued or in flight, sampled on submission
+
+	/// delivered bytes per second
+	double
+	throughput() const
+	{
+		return seconds > 0 ? bytes / seconds : 0;
+	}
+};
+
+/**
+*	\brief	asynchronous read engine shared by the stream backends.
+*	Reads are split into chunk sized requests and tracked per tag, a tag being
+*	one buffer of the stream.
+*/
+class stream_engine
+{
+	public:
+		virtual ~stream_engine() = default;
+
+		/// queue a read of bytes at offset of fd into dst, accounted to tag
+		virtual void read(size_t tag, int fd, char* dst, size_t bytes, off_t offset) = 0;
+
+		/// block until every read of tag completed, throws the first error of the tag
+		virtual void wait(size_t tag) = 0;
+
+		/// true if every read of tag completed, without blocking
+		virtual bool done(size_t tag) = 0;
+
+		/// name of the backend
+		virtual const char* name() const = 0;
+
+		/// largest and mean number of requests queued or in flight
+		std::tuple<size_t, double>
+		depth() const
+		{
+			return {_max_depth, _samples ? _depth_sum / _samples : 0.0};
+		}
+
+	protected:
+		/// one chunk of a read
+		struct request
+		{
+			size_t tag;
+			int fd;
+			char* dst;
+			size_t bytes;
+			off_t offset;
+		};
+
+		/// outstanding requests and first error of a tag
+		struct tag_state
+		{
+			size_t outstanding = 0;
+			int error = 0;
+		};
+
+		stream_engine(size_t tags, size_t chunk):
+		_tags(tags),
+		_chunk(std::max<size_t>(chunk, 1))
+		{}
+
+		/// split a read into chunk sized requests
+		template<class F>
+		void
+		split(size_t tag, int fd, char* dst, size_t bytes, off_t offset, F&& push)
+		{
+			for (size_t done = 0; done < bytes; done += _chunk)
+			{
+				_tags[tag].outstanding++;
+				push(request{tag, fd, dst + done, std::min(_chunk, bytes - done), offset + static_cast<off_t>(done)});
+			}
+		}
+
+		/// retire a request of tag, recording err if it is the first failure
+		void
+		retire(size_t tag, int err)
+		{
+			if (err && !_tags[tag].error)
+				_tags[tag].error = err;
+			_tags[tag].outstanding--;
+		}
+
+		/// throw the error of a completed tag, the tag stays failed
+		void
+		check(size_t tag)
+		{
+			if (int err = _tags[tag].error)
+				throw std::system_error(err, std::generic_category(), "cstream: read failed");
+		}
+
+		void
+		sample(size_t depth)
+		{
+			_max_depth = std::max(_max_depth, depth);
+			_depth_sum += depth;
+			_samples++;
+		}
+
+		std::vector<tag_state> _tags;
+		size_t _chunk;
+
+	private:
+		size_t _max_depth = 0;
+		size_t _samples = 0;
+		double _depth_sum = 0;
+};
+
+/**
+*	\brief	thread pool backend.
+*	Workers take chunks from a shared queue and read them with pread, so reads
+*	progress in the background while the consumer computes.
+*/
+class stream_pool : public stream_engine
+{
+	public:
+		stream_pool(size_t tags, size_t chunk, size_t threads):
+		stream_engine(tags, chunk)
+		{
+			for (size_t t = 0; t < std::max<size_t>(threads, 1); t++)
+				_workers.emplace_back([this]{ work(); });
+		}
+
+		~stream_pool()
+		{
+			{
+				std::lock_guard lock(_mutex);
+				_stop = true;
+			}
+			_ready.notify_all();
+			for (auto& w : _workers)
+				w.join();
+		}
+
+		void
+		read(size_t tag, int fd, char* dst, size_t bytes, off_t offset) override
+		{
+			{
+				std::lock_guard lock(_mutex);
+				split(tag, fd, dst, bytes, offset, [&](const request& r){ _queue.push_back(r); });
+				sample(_queue.size() + _busy);
+			}
+			_ready.notify_all();
+		}
+
+		void
+		wait(size_t tag) override
+		{
+			std::unique_lock lock(_mutex);
+			_done.wait(lock, [&]{ return _tags[tag].outstanding == 0; });
+			check(tag);
+		}
+
+		bool
+		done(size_t tag) override
+		{
+			std::lock_guard lock(_mutex);
+			return _tags[tag].outstanding == 0;
+		}
+
+		const char*
+		name() const override
+		{
+			return "threads";
+		}
+
+	private:
+		void
+		work()
+		{
+			std::unique_lock lock(_mutex);
+			for (;;)
+			{
+				_ready.wait(lock, [&]{ return _stop || !_queue.empty(); });
+				if (_stop)
+					return;
+
+				request r = _queue.front();
+				_queue.pop_front();
+				_busy++;
+				lock.unlock();
+
+				int err = 0;
+				while (r.bytes)
+				{
+					ssize_t n = pread(r.fd, r.dst, r.bytes, r.offset);
+					if (n < 0 && errno == EINTR)
+						continue;
+					if (n <= 0)
+					{
+						err = n < 0 ? errno : EIO;
+						break;
+					}
+					r.dst += n;
+					r.bytes -= n;
+					r.offset += n;
+				}
+
+				lock.lock();
+				_busy--;
+				retire(r.tag, err);
+				_done.notify_all();
+			}
+		}
+
+		std::mutex _mutex;
+		std::condition_variable _ready; ///< signalled when requests are queued
+		std::condition_variable _done; ///< signalled when a request retires
+		std::deque<request> _queue;
+		size_t _busy = 0;
+		bool _stop = false;
+		std::vector<std::thread> _workers;
+};
+
+#if CSTREAM_URING
+/**
+*	\brief	io_uring backend.
+*	Talks to the kernel through the raw io_uring_setup and io_uring_enter system
+*	calls and the mmapped submission and completion rings, so no liburing is needed.
+*	Reads are submitted up to the ring depth; chunks beyond it wait in a local queue.
+*	A completion thread blocks on the ring, reaps finished reads and refills the ring
+*	from the queue, so arrays larger than depth * chunk keep loading while the
+*	consumer computes.
+*/
+class stream_uring : public stream_engine
+{
+	public:
+		stream_uring(size_t tags, size_t chunk, size_t depth):
+		stream_engine(tags, chunk)
+		{
+			io_uring_params p{};
+			_fd = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(std::max<size_t>(depth, 1)), &p));
+			if (_fd < 0)
+				throw std::system_error(errno, std::generic_category(), "cstream: io_uring_setup");
+
+			_sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+			_cq_len = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+			bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+			if (single)
+				_sq_len = _cq_len = std::max(_sq_len, _cq_len);
+
+			_sq = map(_sq_len, IORING_OFF_SQ_RING);
+			_cq = single ? _sq : map(_cq_len, IORING_OFF_CQ_RING);
+			_sqe_len = p.sq_entries * sizeof(io_uring_sqe);
+			_sqes = static_cast<io_uring_sqe*>(map(_sqe_len, IORING_OFF_SQES));
+
+			char* sq = static_cast<char*>(_sq);
+			char* cq = static_cast<char*>(_cq);
+			_sq_head = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+			_sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+			_sq_mask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+			_sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+			_cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+			_cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+			_cq_mask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+			_cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+			_entries = p.sq_entries;
+			_slots.resize(_entries);
+			_iovecs.resize(_entries);
+			for (unsigned i = 0; i < _entries; i++)
+				_free.push_back(_entries - 1 - i);
+
+			_reaper = std::thread([this]{ complete(); });
+		}
+
+		~stream_uring()
+		{
+			// the kernel writes into the buffers until every submitted read completes,
+			// the completion thread drains the ring before it exits
+			{
+				std::lock_guard lock(_mutex);
+				_queue.clear();
+				_stop = true;
+			}
+			_work.notify_all();
+			_reaper.join();
+			release();
+		}
+
+		void
+		read(size_t tag, int fd, char* dst, size_t bytes, off_t offset) override
+		{
+			{
+				std::lock_guard lock(_mutex);
+				split(tag, fd, dst, bytes, offset, [&](const request& r){ _queue.push_back(r); });
+				sample(_queue.size() + _inflight);
+				submit();
+			}
+			_work.notify_all();
+		}
+
+		void
+		wait(size_t tag) override
+		{
+			std::unique_lock lock(_mutex);
+			_done.wait(lock, [&]{ return _tags[tag].outstanding == 0 || _failure; });
+			if (_failure)
+				throw std::system_error(_failure, std::generic_category(), "cstream: io_uring_enter");
+			check(tag);
+		}
+
+		bool
+		done(size_t tag) override
+		{
+			std::lock_guard lock(_mutex);
+			return _tags[tag].outstanding == 0 || _failure;
+		}
+
+		const char*
+		name() const override
+		{
+			return "io_uring";
+		}
+
+	private:
+		void*
+		map(size_t len, off_t offset)
+		{
+			void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, offset);
+			if (p == MAP_FAILED)
+			{
+				int err = errno;
+				release();
+				throw std::system_error(err, std::generic_category(), "cstream: mmap of io_uring rings");
+			}
+			return p;
+		}
+
+		void
+		release()
+		{
+			if (_sqes)
+				munmap(_sqes, _sqe_len);
+			if (_cq && _cq != _sq)
+				munmap(_cq, _cq_len);
+			if (_sq)
+				munmap(_sq, _sq_len);
+			if (_fd >= 0)
+				close(_fd);
+			_sqes = nullptr;
+			_sq = _cq = nullptr;
+			_fd = -1;
+		}
+
+		/// completion thread: wait for reads, retire them and refill the ring
+		void
+		complete()
+		{
+			std::unique_lock lock(_mutex);
+			for (;;)
+			{
+				_work.wait(lock, [&]{ return _inflight > 0 || _stop; });
+				if (_inflight == 0)
+					return;
+
+				// also passes on entries whose submission failed earlier
+				unsigned pending = std::exchange(_unsubmitted, 0);
+				lock.unlock();
+				long n = enter(pending, 1);
+				lock.lock();
+
+				if (n < 0)
+				{
+					// the ring is unusable, fail every wait instead of blocking it forever
+					_unsubmitted += pending;
+					_failure = static_cast<int>(-n);
+					_done.notify_all();
+					return;
+				}
+				_unsubmitted += pending - std::min<unsigned>(pending, static_cast<unsigned>(n));
+
+				reap();
+				if (!_stop)
+				{
+					// entries left unsubmitted by a failure are retried on the next pass
+					try { submit(); }
+					catch (const std::system_error&) {}
+				}
+				_done.notify_all();
+			}
+		}
+
+		/// move queued chunks into free ring entries and hand them to the kernel, called under _mutex
+		void
+		submit()
+		{
+			unsigned tail = *_sq_tail;
+			unsigned count = 0;
+			while (!_queue.empty() && !_free.empty())
+			{
+				unsigned slot = _free.back();
+				_free.pop_back();
+				_slots[slot] = _queue.front();
+				_queue.pop_front();
+
+				const request& r = _slots[slot];
+				_iovecs[slot] = iovec{r.dst, r.bytes};
+				unsigned idx = (tail + count) & _sq_mask;
+				io_uring_sqe& sqe = _sqes[idx];
+				std::memset(&sqe, 0, sizeof(sqe));
+				// READV is available since io_uring itself (5.1), plain READ only since 5.6
+				sqe.opcode = IORING_OP_READV;
+				sqe.fd = r.fd;
+				sqe.addr = reinterpret_cast<uint64_t>(&_iovecs[slot]);
+				sqe.len = 1;
+				sqe.off = static_cast<uint64_t>(r.offset);
+				sqe.user_data = slot;
+				_sq_array[idx] = idx;
+				count++;
+			}
+			if (count)
+			{
+				std::atomic_ref<unsigned>(*_sq_tail).store(tail + count, std::memory_order_release);
+				_unsubmitted += count;
+				_inflight += count;
+			}
+			if (_unsubmitted)
+			{
+				long n = enter(_unsubmitted, 0);
+				if (n < 0)
+					throw std::system_error(static_cast<int>(-n), std::generic_category(), "cstream: io_uring_enter");
+				_unsubmitted -= std::min<unsigned>(_unsubmitted, static_cast<unsigned>(n));
+			}
+		}
+
+		/**
+		 * \brief   pass to_submit new ring entries to the kernel and wait for min_complete completions
+		 * \returns the number of entries submitted, or -errno
+		 */
+		long
+		enter(unsigned to_submit, unsigned min_complete)
+		{
+			for (;;)
+			{
+				unsigned flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+				long n = syscall(__NR_io_uring_enter, _fd, to_submit, min_complete, flags, nullptr, 0);
+				if (n >= 0 || errno != EINTR)
+					return n >= 0 ? n : -errno;
+			}
+		}
+
+		/// consume the completion ring, called under _mutex; short reads requeue their remainder
+		void
+		reap()
+		{
+			unsigned head = *_cq_head;
+			unsigned tail = std::atomic_ref<unsigned>(*_cq_tail).load(std::memory_order_acquire);
+			for (; head != tail; head++)
+			{
+				const io_uring_cqe& cqe = _cqes[head & _cq_mask];
+				unsigned slot = static_cast<unsigned>(cqe.user_data);
+				request r = _slots[slot];
+				int res = cqe.res;
+				_free.push_back(slot);
+				_inflight--;
+
+				if (res == -EINTR || res == -EAGAIN)
+					_queue.push_front(r);
+				else if (res <= 0)
+					retire(r.tag, res < 0 ? -res : EIO);
+				else if (static_cast<size_t>(res) < r.bytes)
+				{
+					r.dst += res;
+					r.bytes -= res;
+					r.offset += res;
+					_queue.push_front(r);
+				}
+				else
+					retire(r.tag, 0);
+			}
+			std::atomic_ref<unsigned>(*_cq_head).store(head, std::memory_order_release);
+		}
+
+		int _fd = -1;
+		void* _sq = nullptr;
+		void* _cq = nullptr;
+		size_t _sq_len = 0;
+		size_t _cq_len = 0;
+		size_t _sqe_len = 0;
+		io_uring_sqe* _sqes = nullptr;
+		unsigned* _sq_head = nullptr;
+		unsigned* _sq_tail = nullptr;
+		unsigned* _sq_array = nullptr;
+		unsigned _sq_mask = 0;
+		unsigned* _cq_head = nullptr;
+		unsigned* _cq_tail = nullptr;
+		unsigned _cq_mask = 0;
+		io_uring_cqe* _cqes = nullptr;
+
+		unsigned _entries = 0;
+		unsigned _inflight = 0; ///< requests owned by the kernel
+		unsigned _unsubmitted = 0; ///< ring entries not yet passed to io_uring_enter
+		std::vector<request> _slots; ///< request of each ring entry, indexed by user_data
+		std::vector<iovec> _iovecs; ///< single buffer vector of each ring entry
+		std::vector<unsigned> _free; ///< unused ring entries
+		std::deque<request> _queue; ///< chunks waiting for a ring entry
+
+		std::mutex _mutex; ///< guards the rings, the queue and the tags
+		std::condition_variable _work; ///< signalled when reads are submitted or on shutdown
+		std::condition_variable _done; ///< signalled when reads retire
+		bool _stop = false;
+		int _failure = 0; ///< errno of a failed io_uring_enter in the completion thread
+		std::thread _reaper; ///< completion thread
+};
+#endif
+
+/**
+* 	\brief	asynchronous loader of a sequence of carrays stored on disk.
+*	The stream owns a fixed set of A aligned buffers. While the consumer works on
+*	one array the following ones are read in the background, and a buffer is
+*	recycled for the next pending array once the consumer moves on, so nothing is
+*	allocated after construction. Arrays are delivered in order, each array being
+*	the raw row major contents of a file, or of a frame in a file of frames.
+*	T - Type, must be trivially copyable
+*	N - Rank
+*	A - Alignment
+*/
+template<class T, size_t N, size_t A>
+class cstream
+{
+	static_assert(std::is_trivially_copyable_v<T>, "streamed carrays require a trivially copyable type");
+
+	public:
+		/**
+		 *	\brief stream one array per file.
+		 *	\param 	paths	files in delivery order, each holding one array
+		 *	\param 	shape	extent of each dimension of the arrays
+		 *	\param 	options	buffering and backend configuration
+		 */
+		cstream(const std::vector<std::string>& paths, const std::array<size_t, N>& shape, const stream_options& options = {}):
+		_shape(shape),
+		_bytes(bytes(shape))
+		{
+			for (const auto& p : paths)
+				_items.push_back({p, 0});
+			start(options);
+		}
+
+		/**
+		 *	\brief stream consecutive arrays of one file.
+		 *	\param 	path	file holding count arrays back to back
+		 *	\param 	count	number of arrays
+		 *	\param 	shape	extent of each dimension of the arrays
+		 *	\param 	options	buffering and backend configuration
+		 */
+		cstream(const std::string& path, size_t count, const std::array<size_t, N>& shape, const stream_options& options = {}):
+		_shape(shape),
+		_bytes(bytes(shape))
+		{
+			for (size_t i = 0; i < count; i++)
+				_items.push_back({path, static_cast<off_t>(i * _bytes)});
+			start(options);
+		}
+
+		cstream(const cstream&) = delete;
+		cstream& operator=(const cstream&) = delete;
+
+		/**
+		 *	\brief blocking pop of the next array.
+		 *	The array stays valid until the following call, which recycles its buffer.
+		 *	A failure to open or read array i is raised once the arrays before it were
+		 *	delivered, and again on every later call; the stream does not skip past it.
+		 *	\param 	index	if not null, receives the position of the array in the sequence
+		 *	\return the loaded array, or nullptr once the sequence is exhausted
+		 */
+		carray<T, N, A>*
+		next(size_t* index = nullptr)
+		{
+			if (_held)
+			{
+				// the buffer of the array the consumer just finished takes the next pending array
+				_held = false;
+				size_t pending = _cursor - 1 + _buffers.size();
+				if (pending < _items.size())
+					submit(pending);
+			}
+
+			if (_error && _cursor >= _failed)
+				std::rethrow_exception(_error);
+			if (_cursor == _items.size())
+				return nullptr;
+
+			size_t slot = _cursor % _buffers.size();
+			auto t0 = std::chrono::steady_clock::now();
+			try
+			{
+				_engine->wait(slot);
+			}
+			catch (...)
+			{
+				fail(_cursor);
+				throw;
+			}
+			auto t1 = std::chrono::steady_clock::now();
+			_stalled += std::chrono::duration<double>(t1 - t0).count();
+			_files[slot].reset();
+
+			_last = t1;
+			_held = true;
+			if (index)
+				*index = _cursor;
+			_cursor++;
+			return &_buffers[slot];
+		}
+
+		/**
+		 *	\brief deliver every remaining array to a consumer callback.
+		 *	\param 	f	callable as f(carray<T, N, A>& array, size_t index)
+		 */
+		template<class F>
+		void
+		consume(F&& f)
+		{
+			size_t i;
+			while (carray<T, N, A>* a = next(&i))
+				f(*a, i);
+		}
+
+		/**	\brief True if next() would return without waiting for reads. */
+		bool
+		ready()
+		{
+			if ((_error && _cursor >= _failed) || _cursor == _items.size())
+				return true;
+			// a single buffer is still held by the consumer, its next read has not started
+			if (_held && _buffers.size() == 1)
+				return false;
+			return _engine->done(_cursor % _buffers.size());
+		}
+
+		/**	\brief Number of arrays in the sequence. */
+		size_t
+		size() const
+		{
+			return _items.size();
+		}
+
+		/**	\brief Number of buffers cycled by the stream. */
+		size_t
+		buffers() const
+		{
+			return _buffers.size();
+		}
+
+		/**	\brief Throughput, stall time and queue depth so far. */
+		stream_stats
+		stats() const
+		{
+			auto [max_depth, mean_depth] = _engine->depth();
+			return stream_stats{
+				_engine->name(),
+				_cursor,
+				_cursor * _bytes,
+				std::chrono::duration<double>(_last - _start).count(),
+				_stalled,
+				max_depth,
+				mean_depth};
+		}
+
+	private:
+		struct item
+		{
+			std::string path;
+			off_t offset;
+		};
+
+		/// file descriptor closed on destruction
+		struct descriptor
+		{
+			int fd = -1;
+			descriptor() = default;
+			descriptor(const descriptor&) = delete;
+			descriptor& operator=(const descriptor&) = delete;
+			~descriptor() { reset(); }
+			void reset(int f = -1) { if (fd >= 0) close(fd); fd = f; }
+		};
+
+		static size_t
+		bytes(const std::array<size_t, N>& shape)
+		{
+			return std::accumulate(shape.begin(), shape.end(), sizeof(T), std::multiplies<size_t>());
+		}
+
+		void
+		start(const stream_options& options)
+		{
+			if (options.buffers < 1)
+				throw std::invalid_argument("cstream: at least one buffer is required");
+
+			size_t count = std::min(options.buffers, std::max<size_t>(_items.size(), 1));
+			for (size_t b = 0; b < count; b++)
+				_buffers.push_back(std::apply([](auto... n){ return carray<T, N, A>(n...); }, _shape));
+			_files = std::make_unique<descriptor[]>(count);
+			_engine = engine(options, count);
+
+			_start = _last = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < count && i < _items.size(); i++)
+				submit(i);
+		}
+
+		static std::unique_ptr<stream_engine>
+		engine(const stream_options& options, size_t tags)
+		{
+#if CSTREAM_URING
+			if (options.backend != stream_backend::threads)
+			{
+				try
+				{
+					return std::make_unique<stream_uring>(tags, options.chunk, options.depth);
+				}
+				catch (const std::system_error&)
+				{
+					// kernels without io_uring, or with it disabled, use the thread pool
+					if (options.backend == stream_backend::uring)
+						throw;
+				}
+			}
+#else
+			if (options.backend == stream_backend::uring)
+				throw std::runtime_error("cstream: io_uring is not available on this platform");
+#endif
+			return std::make_unique<stream_pool>(tags, options.chunk, options.threads);
+		}
+
+		/// record the failure of array i, the earliest failed array is the one raised
+		void
+		fail(size_t i)
+		{
+			if (!_error || i < _failed)
+			{
+				_error = std::current_exception();
+				_failed = i;
+			}
+		}
+
+		/// queue the read of array i, a failure is recorded and raised when array i comes due
+		void
+		submit(size_t i)
+		{
+			// arrays after a failed one are never read
+			if (_error)
+				return;
+			try
+			{
+				read(i);
+			}
+			catch (...)
+			{
+				fail(i);
+			}
+		}
+
+		/// open the file of array i and queue its read into the buffer it maps to
+		void
+		read(size_t i)
+		{
+			const item& it = _items[i];
+			size_t slot = i % _buffers.size();
+
+			int fd = open(it.path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+				throw std::system_error(errno, std::generic_category(), "cstream: open " + it.path);
+			_files[slot].reset(fd);
+
+			struct stat st;
+			if (fstat(fd, &st) != 0)
+				throw std::system_error(errno, std::generic_category(), "cstream: fstat " + it.path);
+			if (static_cast<size_t>(st.st_size) < it.offset + _bytes)
+				throw std::runtime_error("cstream: " + it.path + " is shorter than the arrays it should hold");
+
+			_engine->read(slot, fd, reinterpret_cast<char*>(_buffers[slot].begin()), _bytes, it.offset);
+		}
+
+		std::array<size_t, N> _shape;
+		size_t _bytes; ///< bytes of one array
+		std::vector<item> _items;
+		std::vector<carray<T, N, A>> _buffers;
+		std::unique_ptr<descriptor[]> _files; ///< open file of each buffer while it is read
+		std::unique_ptr<stream_engine> _engine; ///< declared last, drained before the buffers are released
+
+		size_t _cursor = 0; ///< index of the next array to deliver
+		bool _held = false; ///< the consumer holds array _cursor - 1
+		std::exception_ptr _error; ///< failure of array _failed, raised once it comes due
+		size_t _failed = 0;
+		std::chrono::steady_clock::time_point _start;
+		std::chrono::steady_clock::time_point _last;
+		double _stalled = 0;
+};
+
+#endif //__C_STREAM_H__
@@ -0,0 +1,357 @@
+#ifndef __GEMM_H__
+#define __GEMM_H__
+
+// Copyright (c) 2025  Constantine Papakonstantinou
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/**
+ * \file gemm.h header only support for blocked matrix multiplication of carray matrices
+ * \author cpapakonstantinou
+ * \date 2025
+ **/
+#include <algorithm>
+#include <stdexcept>
+#include <immintrin.h>
+#include <carray.h>
+#include <parallel.h>
+
+/**
+*	\brief	vector operations used by the gemm micro kernel.
+*	The micro kernel computes an mr x (nv * width) block of C held in registers.
+*	The generic version operates on scalars, float and double are specialized
+*	for AVX-512 or AVX2 with FMA when the target supports them.
+*/
+template<class T>
+struct gemm_simd
+{
+	using vec = T;
+	static constexpr size_t width = 1, mr = 4, nv = 4;
+
+	static inline vec zero() { return T(0); }
+	static inline vec load(const T* p) { return *p; }
+	static inline void store(T* p, vec v) { *p = v; }
+	static inline vec broadcast(T x) { return x; }
+	static inline vec mul(vec a, vec b) { return a * b; }
+	static inline vec fmadd(vec a, vec b, vec c) { return a * b + c; }
+};
+
+#if defined(__AVX512F__)
+template<>
+struct gemm_simd<float>
+{
+	using vec = __m512;
+	static constexpr size_t width = 16, mr = 14, nv = 2;
+
+	static inline vec zero() { return _mm512_setzero_ps(); }
+	static inline vec load(const float* p) { return _mm512_loadu_ps(p); }
+	static inline void store(float* p, vec v) { _mm512_storeu_ps(p, v); }
+	static inline vec broadcast(float x) { return _mm512_set1_ps(x); }
+	static inline vec mul(vec a, vec b) { return _mm512_mul_ps(a, b); }
+	static inline vec fmadd(vec a, vec b, vec c) { return _mm512_fmadd_ps(a, b, c); }
+};
+
+template<>
+struct gemm_simd<double>
+{
+	using vec = __m512d;
+	static constexpr size_t width = 8, mr = 14, nv = 2;
+
+	static inline vec zero() { return _mm512_setzero_pd(); }
+	static inline vec load(const double* p) { return _mm512_loadu_pd(p); }
+	static inline void store(double* p, vec v) { _mm512_storeu_pd(p, v); }
+	static inline vec broadcast(double x) { return _mm512_set1_pd(x); }
+	static inline vec mul(vec a, vec b) { return _mm512_mul_pd(a, b); }
+	static inline vec fmadd(vec a, vec b, vec c) { return _mm512_fmadd_pd(a, b, c); }
+};
+#elif defined(__AVX2__) && defined(__FMA__)
+template<>
+struct gemm_simd<float>
+{
+	using vec = __m256;
+	static constexpr size_t width = 8, mr = 6, nv = 2;
+
+	static inline vec zero() { return _mm256_setzero_ps(); }
+	static inline vec load(const float* p) { return _mm256_loadu_ps(p); }
+	static inline void store(float* p, vec v) { _mm256_storeu_ps(p, v); }
+	static inline vec broadcast(float x) { return _mm256_set1_ps(x); }
+	static inline vec mul(vec a, vec b) { return _mm256_mul_ps(a, b); }
+	static inline vec fmadd(vec a, vec b, vec c) { return _mm256_fmadd_ps(a, b, c); }
+};
+
+template<>
+struct gemm_simd<double>
+{
+	using vec = __m256d;
+	static constexpr size_t width = 4, mr = 6, nv = 2;
+
+	static inline vec zero() { return _mm256_setzero_pd(); }
+	static inline vec load(const double* p) { return _mm256_loadu_pd(p); }
+	static inline void store(double* p, vec v) { _mm256_storeu_pd(p, v); }
+	static inline vec broadcast(double x) { return _mm256_set1_pd(x); }
+	static inline vec mul(vec a, vec b) { return _mm256_mul_pd(a, b); }
+	static inline vec fmadd(vec a, vec b, vec c) { return _mm256_fmadd_pd(a, b, c); }
+};
+#endif
+
+/**
+*	\brief	cache blocking of the gemm loop nest.
+*	mr x nr is the register block of the micro kernel,
+*	kc x nr panels of B are sized for L1, mc x kc blocks of A for L2
+*	and kc x nc panels of B for L3.
+*/
+template<class T>
+struct gemm_block
+{
+	static constexpr size_t mr = gemm_simd<T>::mr;
+	static constexpr size_t nr = gemm_simd<T>::nv * gemm_simd<T>::width;
+	static constexpr size_t kc = 256;
+	static constexpr size_t mc = std::max<size_t>(mr, (128 * 1024 / (kc * sizeof(T))) / mr * mr);
+	static constexpr size_t nc = std::max<size_t>(nr, (2 * 1024 * 1024 / (kc * sizeof(T))) / nr * nr);
+	static constexpr size_t align = 64;
+};
+
+/**
+ * \brief   pack an mr x kc panel of A so that the mr values of each k are contiguous.
+ * Rows past m are padded with zeros.
+ * \param   a       first element of the panel in A
+ * \param   lda     row stride of A
+ * \param   m       valid rows of the panel
+ * \param   kc      depth of the panel
+ * \param   ap      packed panel
+ */
+template<class T>
+static inline void
+gemm_pack_a(const T* a, size_t lda, size_t m, size_t kc, T* ap)
+{
+	constexpr size_t MR = gemm_block<T>::mr;
+	for (size_t k = 0; k < kc; ++k)
+		for (size_t r = 0; r < MR; ++r)
+			ap[k * MR + r] = (r < m) ? a[r * lda + k] : T(0);
+}
+
+/**
+ * \brief   pack a kc x nr panel of B so that the nr values of each k are contiguous.
+ * Columns past n are padded with zeros.
+ * \param   b       first element of the panel in B
+ * \param   ldb     row stride of B
+ * \param   n       valid columns of the panel
+ * \param   kc      depth of the panel
+ * \param   bp      packed panel
+ */
+template<class T>
+static inline void
+gemm_pack_b(const T* b, size_t ldb, size_t n, size_t kc, T* bp)
+{
+	constexpr size_t NR = gemm_block<T>::nr;
+	for (size_t k = 0; k < kc; ++k)
+	{
+		std::copy(b + k * ldb, b + k * ldb + n, bp + k * NR);
+		std::fill(bp + k * NR + n, bp + (k + 1) * NR, T(0));
+	}
+}
+
+/**
+ * \brief   register blocked micro kernel, C = alpha * Ap * Bp + beta * C on an mr x nr block.
+ * C is not read when beta is zero.
+ * \param   kc      depth of the packed panels
+ * \param   ap      packed mr x kc panel of A
+ * \param   bp      packed kc x nr panel of B
+ * \param   c       first element of the block in C
+ * \param   ldc     row stride of C
+ * \param   alpha   scale of the product
+ * \param   beta    scale of C
+ */
+template<class T>
+static inline void
+gemm_micro(size_t kc, const T* ap, const T* bp, T* c, size_t ldc, T alpha, T beta)
+{
+	using S = gemm_simd<T>;
+	using vec = typename S::vec;
+	constexpr size_t MR = S::mr, NV = S::nv, W = S::width;
+
+	vec acc[MR][NV];
+	for (size_t r = 0; r < MR; ++r)
+		for (size_t v = 0; v < NV; ++v)
+			acc[r][v] = S::zero();
+
+	for (size_t k = 0; k < kc; ++k, ap += MR, bp += NV * W)
+	{
+		vec bv[NV];
+		for (size_t v = 0; v < NV; ++v)
+			bv[v] = S::load(bp + v * W);
+		for (size_t r = 0; r < MR; ++r)
+		{
+			vec av = S::broadcast(ap[r]);
+			for (size_t v = 0; v < NV; ++v)
+				acc[r][v] = S::fmadd(av, bv[v], acc[r][v]);
+		}
+	}
+
+	vec va = S::broadcast(alpha), vb = S::broadcast(beta);
+	for (size_t r = 0; r < MR; ++r)
+		for (size_t v = 0; v < NV; ++v)
+		{
+			T* p = c + r * ldc + v * W;
+			if (beta == T(0))
+				S::store(p, S::mul(va, acc[r][v]));
+			else
+				S::store(p, S::fmadd(va, acc[r][v], S::mul(vb, S::load(p))));
+		}
+}
+
+/**
+ * \brief   micro kernel for ragged m x n edge blocks, the full block is computed into scratch
+ * and only the valid part is written back to C.
+ */
+template<class T>
+static inline void
+gemm_micro_edge(size_t m, size_t n, size_t kc, const T* ap, const T* bp, T* c, size_t ldc, T alpha, T beta)
+{
+	constexpr size_t MR = gemm_block<T>::mr, NR = gemm_block<T>::nr;
+	alignas(64) T tmp[MR * NR];
+
+	gemm_micro(kc, ap, bp, tmp, NR, alpha, T(0));
+	for (size_t r = 0; r < m; ++r)
+		for (size_t j = 0; j < n; ++j)
+			c[r * ldc + j] = (beta == T(0)) ? tmp[r * NR + j] : tmp[r * NR + j] + beta * c[r * ldc + j];
+}
+
+/**
+ * \brief   blocked matrix multiplication C = alpha * A * B + beta * C on row major strided matrices.
+ * Goto style loop nest: B is packed into kc x nc panels shared by all threads.
+ * Each thread packs the mc x kc blocks of A it multiplies into its own L2 sized
+ * buffer right before using them, and the micro kernel runs over mr x nr register
+ * blocks. When there are fewer blocks of A than threads, the panels of B are
+ * split as well and each part packs its own copy of the A block.
+ * \param   m       rows of A and C
+ * \param   n       columns of B and C
+ * \param   k       columns of A and rows of B
+ * \param   alpha   scale of the product
+ * \param   a       matrix A
+ * \param   lda     row stride of A
+ * \param   b       matrix B
+ * \param   ldb     row stride of B
+ * \param   beta    scale of C
+ * \param   c       matrix C
+ * \param   ldc     row stride of C
+ * \param   threads number of threads
+ * \param   align   alignment of the packing buffers, at least gemm_block<T>::align
+ */
+template<class T>
+void
+gemm_blocked(size_t m, size_t n, size_t k, T alpha, const T* a, size_t lda, const T* b, size_t ldb,
+	T beta, T* c, size_t ldc, size_t threads = default_threads(), size_t align = gemm_block<T>::align)
+{
+	using G = gemm_block<T>;
+	constexpr size_t MR = G::mr, NR = G::nr, KC = G::kc, MC = G::mc, NC = G::nc;
+
+	if (m == 0 || n == 0)
+		return;
+
+	if (k == 0 || alpha == T(0))
+	{
+		for (size_t i = 0; i < m; ++i)
+			for (size_t j = 0; j < n; ++j)
+				c[i * ldc + j] = (beta == T(0)) ? T(0) : beta * c[i * ldc + j];
+		return;
+	}
+
+	threads = std::max<size_t>(threads, 1);
+	align = std::max(align, G::align);
+	size_t np = (std::min(n, NC) + NR - 1) / NR, nmb = (m + MC - 1) / MC;
+	auto bp = make_unique_aarray<T>(align, np * NR * KC);
+
+	for (size_t jc = 0; jc < n; jc += NC)
+	{
+		size_t nc = std::min(NC, n - jc), njr = (nc + NR - 1) / NR;
+
+		for (size_t pc = 0; pc < k; pc += KC)
+		{
+			size_t kc = std::min(KC, k - pc);
+			T bc = (pc == 0) ? beta : T(1);
+
+			parallel_for(0, njr, [&](size_t first, size_t last){
+				for (size_t jr = first; jr < last; ++jr)
+					gemm_pack_b(b + pc * ldb + jc + jr * NR, ldb, std::min(NR, nc - jr * NR), kc, &bp[jr * NR * kc]);
+			}, threads);
+
+			// task t multiplies block t / parts of A with part t % parts of the B panel
+			size_t parts = std::min(njr, (threads + nmb - 1) / nmb);
+			parallel_for(0, nmb * parts, [&](size_t first, size_t last){
+				auto ap = make_unique_aarray<T>(align, MC * KC);
+				size_t packed = nmb;
+
+				for (size_t t = first; t < last; ++t)
+				{
+					size_t ib = t / parts, part = t % parts;
+					size_t ic = ib * MC, mc = std::min(MC, m - ic);
+
+					if (packed != ib)
+					{
+						for (size_t ir = 0; ir < mc; ir += MR)
+							gemm_pack_a(a + (ic + ir) * lda + pc, lda, std::min(MR, mc - ir), kc, &ap[ir * kc]);
+						packed = ib;
+					}
+
+					for (size_t jb = njr * part / parts; jb < njr * (part + 1) / parts; ++jb)
+					{
+						size_t jr = jb * NR, nr = std::min(NR, nc - jr);
+						const T* bpanel = &bp[jr * kc];
+
+						for (size_t ir = 0; ir < mc; ir += MR)
+						{
+							const T* apanel = &ap[ir * kc];
+							T* cblock = c + (ic + ir) * ldc + jc + jr;
+							size_t mr = std::min(MR, mc - ir);
+
+							if (mr == MR && nr == NR)
+								gemm_micro(kc, apanel, bpanel, cblock, ldc, alpha, bc);
+							else
+								gemm_micro_edge(mr, nr, kc, apanel, bpanel, cblock, ldc, alpha, bc);
+						}
+					}
+				}
+			}, threads);
+		}
+	}
+}
+
+/**
+ * \brief   matrix multiplication of carray matrices, C = alpha * A * B + beta * C
+ * \param   a       matrix of shape (m, k)
+ * \param   b       matrix of shape (k, n)
+ * \param   c       matrix of shape (m, n), not read when beta is zero
+ * \param   alpha   scale of the product
+ * \param   beta    scale of C
+ * \param   threads number of threads
+ */
+template<class T, size_t A, size_t Ab, size_t Ac>
+void
+gemm(carray<T, 2, A>& a, carray<T, 2, Ab>& b, carray<T, 2, Ac>& c, T alpha = T(1), T beta = T(0),
+	size_t threads = default_threads())
+{
+	if (a.shape(1) != b.shape(0) || c.shape(0) != a.shape(0) || c.shape(1) != b.shape(1))
+		throw std::invalid_argument("gemm: matrix shapes do not conform");
+
+	gemm_blocked<T>(a.shape(0), b.shape(1), a.shape(1), alpha, a.begin(), a.shape(1), b.begin(), b.shape(1),
+		beta, c.begin(), c.shape(1), threads, std::max({A, Ab, Ac, gemm_block<T>::align}));
+}
+
+#endif//__GEMM_H__
@@ -0,0 +1,110 @@
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+// Copyright (c) 2025  Constantine Papakonstantinou
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/**
+ * \file parallel.h header only support for splitting loops over carray kernels across threads
+ * \author cpapakonstantinou
+ * \date 2025
+ **/
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief   default number of worker threads used by the carray kernels
+ * \returns the hardware concurrency, or 1 if it cannot be determined
+ */
+static inline size_t
+default_threads()
+{
+	size_t n = std::thread::hardware_concurrency();
+	return n ? n : 1;
+}
+
+/**
+ * \brief   split the range [begin, end) into contiguous chunks and run f(first, last) on each
+ * The calling thread processes the last chunk. With threads <= 1 f is called inline.
+ * Every thread is joined before returning; if chunks throw, the first exception is rethrown.
+ * \param   begin   first index of the range
+ * \param   end     one past the last index of the range
+ * \param   f       callable invoked as f(size_t first, size_t last)
+ * \param   threads number of threads to split the range over
+ */
+template<class F>
+void
+parallel_for(size_t begin, size_t end, F&& f, size_t threads = default_threads())
+{
+	if (end <= begin)
+		return;
+
+	size_t n = end - begin;
+	threads = std::clamp<size_t>(threads, 1, n);
+
+	if (threads == 1)
+	{
+		f(begin, end);
+		return;
+	}
+
+	std::vector<std::exception_ptr> errors(threads);
+	std::vector<std::thread> pool;
+	pool.reserve(threads - 1);
+
+	// joins the workers on every exit path, including a throwing emplace_back
+	struct joiner
+	{
+		std::vector<std::thread>& pool;
+		~joiner()
+		{
+			for (auto& th : pool)
+				th.join();
+		}
+	} join{pool};
+
+	auto run = [&f, &errors](size_t t, size_t first, size_t last){
+		try { f(first, last); }
+		catch (...) { errors[t] = std::current_exception(); }
+	};
+
+	size_t chunk = n / threads, rem = n % threads, first = begin;
+	for (size_t t = 0; t < threads; ++t)
+	{
+		size_t last = first + chunk + (t < rem ? 1 : 0);
+		if (t + 1 == threads)
+			run(t, first, last);
+		else
+			pool.emplace_back(run, t, first, last);
+		first = last;
+	}
+
+	for (auto& th : pool)
+		th.join();
+	pool.clear();
+
+	for (auto& e : errors)
+		if (e)
+			std::rethrow_exception(e);
+}
+
+#endif//__PARALLEL_H__
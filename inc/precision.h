@@ -0,0 +1,455 @@
+#ifndef __PRECISION_H__
+#define __PRECISION_H__
+
+// Copyright (c) 2025  Constantine Papakonstantinou
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/**
+ * \file precision.h header only support for reduced precision carray storage (fp16, bf16, int8)
+ * \author cpapakonstantinou
+ * \date 2025
+ **/
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <immintrin.h>
+#include <carray.h>
+#include <parallel.h>
+
+#if defined(__FLT16_MAX__)
+using float16 = _Float16; ///< IEEE binary16 storage and arithmetic type, named like bfloat16
+#endif
+
+/**
+*	\brief	bfloat16 storage type, the upper 16 bits of an IEEE binary32.
+*	Conversion from float rounds to nearest even and keeps NaNs quiet.
+*	Default construction leaves the value uninitialized like any trivial type in a carray.
+*/
+struct bfloat16
+{
+	uint16_t bits; ///< raw bfloat16 encoding
+
+	bfloat16() = default;
+
+	bfloat16(float f):
+	bits(from_float(f))
+	{}
+
+	operator float() const
+	{
+		return std::bit_cast<float>(static_cast<uint32_t>(bits) << 16);
+	}
+
+	/**	\brief round a float to the nearest bfloat16 encoding */
+	static inline uint16_t
+	from_float(float f)
+	{
+		uint32_t u = std::bit_cast<uint32_t>(f);
+		uint32_t r = (u + 0x7fffu + ((u >> 16) & 1u)) >> 16;
+		return ((u & 0x7fffffffu) > 0x7f800000u) ? static_cast<uint16_t>((u >> 16) | 0x40u) : static_cast<uint16_t>(r);
+	}
+};
+
+/**
+ * \brief   convert n reduced precision values to float
+ * \param   src     source values
+ * \param   dst     destination floats
+ * \param   n       number of values
+ */
+static inline void
+load_f32(const float* src, float* dst, size_t n)
+{
+	std::copy(src, src + n, dst);
+}
+
+/// \copydoc load_f32(const float*, float*, size_t)
+static inline void
+load_f32(const bfloat16* src, float* dst, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+		dst[i] = std::bit_cast<float>(static_cast<uint32_t>(src[i].bits) << 16);
+}
+
+/**
+ * \brief   convert n floats to reduced precision values
+ * \param   src     source floats
+ * \param   dst     destination values
+ * \param   n       number of values
+ */
+static inline void
+store_f32(const float* src, float* dst, size_t n)
+{
+	std::copy(src, src + n, dst);
+}
+
+/// \copydoc store_f32(const float*, float*, size_t)
+static inline void
+store_f32(const float* src, bfloat16* dst, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+		dst[i].bits = bfloat16::from_float(src[i]);
+}
+
+#if defined(__FLT16_MAX__)
+/// \copydoc load_f32(const float*, float*, size_t)
+static inline void
+load_f32(const float16* src, float* dst, size_t n)
+{
+	size_t i = 0;
+#if defined(__AVX512F__)
+	// zero masked forms, the unmasked intrinsics read an undefined register and trip -Wmaybe-uninitialized
+	for (; i + 16 <= n; i += 16)
+		_mm512_storeu_ps(dst + i, _mm512_maskz_cvtph_ps(0xffff, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i))));
+#endif
+#if defined(__F16C__)
+	for (; i + 8 <= n; i += 8)
+		_mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+#endif
+	for (; i < n; ++i)
+		dst[i] = static_cast<float>(src[i]);
+}
+
+/// \copydoc store_f32(const float*, float*, size_t)
+static inline void
+store_f32(const float* src, float16* dst, size_t n)
+{
+	size_t i = 0;
+#if defined(__AVX512F__)
+	for (; i + 16 <= n; i += 16)
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+			_mm512_maskz_cvtps_ph(0xffff, _mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+#endif
+#if defined(__F16C__)
+	for (; i + 8 <= n; i += 8)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+			_mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+#endif
+	for (; i < n; ++i)
+		dst[i] = static_cast<float16>(src[i]);
+}
+#endif
+
+/// number of floats converted at a time by the blocked kernels, sized to stay in L1
+constexpr size_t f32_block = 256;
+
+/**
+ * \brief   convert n values between element types, through fp32 blocks when neither side is float
+ * \param   src     source values
+ * \param   dst     destination values
+ * \param   n       number of values
+ */
+template<class Tin, class Tout>
+static inline void
+convert_n(const Tin* src, Tout* dst, size_t n)
+{
+	if constexpr (std::is_same_v<Tin, Tout>)
+		std::copy(src, src + n, dst);
+	else if constexpr (std::is_same_v<Tin, float>)
+		store_f32(src, dst, n);
+	else if constexpr (std::is_same_v<Tout, float>)
+		load_f32(src, dst, n);
+	else
+	{
+		alignas(64) float tmp[f32_block];
+		for (size_t i = 0; i < n; i += f32_block)
+		{
+			size_t len = std::min(f32_block, n - i);
+			load_f32(src + i, tmp, len);
+			store_f32(tmp, dst + i, len);
+		}
+	}
+}
+
+/**
+ * \brief   bulk conversion of a carray to another element type of the same shape
+ * \param   src     source carray
+ * \param   dst     destination carray
+ * \param   threads number of threads
+ */
+template<class Tin, class Tout, size_t N, size_t A, size_t Ab>
+void
+convert(carray<Tin, N, A>& src, carray<Tout, N, Ab>& dst, size_t threads = default_threads())
+{
+	for (size_t d = 0; d < N; ++d)
+		if (src.shape(d) != dst.shape(d))
+			throw std::invalid_argument("convert: source and destination shapes differ");
+
+	constexpr size_t chunk = 16 * f32_block;
+	size_t n = src.size();
+	const Tin* s = src.begin();
+	Tout* t = dst.begin();
+
+	parallel_for(0, (n + chunk - 1) / chunk, [&](size_t first, size_t last){
+		size_t begin = first * chunk, end = std::min(n, last * chunk);
+		convert_n(s + begin, t + begin, end - begin);
+	}, threads);
+}
+
+/**
+ * \brief   largest finite magnitude of n floats, NaN and infinities are skipped
+ * Sixteen independent lanes keep the reduction vectorizable without reassociation.
+ */
+static inline float
+absmax(const float* x, size_t n)
+{
+	constexpr float finite = std::numeric_limits<float>::max();
+	float m[16] = {};
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+		for (size_t l = 0; l < 16; ++l)
+		{
+			float a = std::abs(x[i + l]);
+			m[l] = std::max(m[l], a <= finite ? a : 0.f);
+		}
+	for (; i < n; ++i)
+	{
+		float a = std::abs(x[i]);
+		m[0] = std::max(m[0], a <= finite ? a : 0.f);
+	}
+	return *std::max_element(m, m + 16);
+}
+
+/**
+* 	\brief	int8 quantized carray with one float scale per block of B contiguous elements.
+*	Element i is stored as round(x / scale) in [-127, 127] with scale = max|x| / 127
+*	over its block, and reads back as values[i] * scales[i / B].
+*	N - Rank
+*	A - Alignment
+*	B - Elements per scale block
+*/
+template<size_t N, size_t A, size_t B = 64>
+class cquant8
+{
+	static_assert(B > 0, "block size must be positive");
+
+	public:
+		static constexpr size_t block = B; ///< elements per scale block
+
+		/**
+		 *	\brief constructor.
+		 *	Variadic constructor which accepts a parameter pack.
+		 *	Parameter pack must expand to N elements.
+		 *
+		 *	\param 	ijk	parameter pack
+		 */
+		template<class... IJK>
+		explicit
+		cquant8(IJK&&... ijk):
+		_values(ijk...),
+		_scales((_values.size() + B - 1) / B)
+		{
+			static_assert(sizeof...(IJK) == N, "number of indices must match rank of array");
+		}
+
+		/**	\brief Dequantized RO operator. */
+		template<typename... IJK>
+		float operator()(IJK... ijk) const
+		{
+			const int8_t* v = &_values(ijk...);
+			size_t i = v - _values.begin();
+			return static_cast<float>(*v) * _scales(i / B);
+		}
+
+		/**	\brief Quantized values. */
+		carray<int8_t, N, A>& values() { return _values; }
+
+		/**	\brief Quantized values. Read-only. */
+		const carray<int8_t, N, A>& values() const { return _values; }
+
+		/**	\brief Scale of every block. */
+		carray<float, 1, A>& scales() { return _scales; }
+
+		/**	\brief Scale of every block. Read-only. */
+		const carray<float, 1, A>& scales() const { return _scales; }
+
+		/**	\brief Extent of dimension i. */
+		size_t shape(size_t i) const { return _values.shape(i); }
+
+		/**	\brief Number of elements. */
+		size_t size() const { return _values.size(); }
+
+		/**	\brief Number of scale blocks. */
+		size_t blocks() const { return _scales.size(); }
+
+	private:
+		carray<int8_t, N, A> _values; ///< quantized values
+		carray<float, 1, A> _scales; ///< scale of every block
+};
+
+/**
+ * \brief   convert len elements of a carray starting at offset to float
+ * \param   src     source carray
+ * \param   offset  first element in row major order
+ * \param   len     number of elements
+ * \param   dst     destination floats
+ */
+template<class T, size_t N, size_t A>
+static inline void
+load_f32(const carray<T, N, A>& src, size_t offset, size_t len, float* dst)
+{
+	load_f32(src.begin() + offset, dst, len);
+}
+
+/// \copydoc load_f32(const carray<T, N, A>&, size_t, size_t, float*)
+template<size_t N, size_t A, size_t B>
+static inline void
+load_f32(const cquant8<N, A, B>& src, size_t offset, size_t len, float* dst)
+{
+	const int8_t* v = src.values().begin();
+	const float* s = src.scales().begin();
+
+	for (size_t i = offset, end = offset + len; i < end;)
+	{
+		size_t stop = std::min(end, (i / B + 1) * B);
+		float scale = s[i / B];
+		for (size_t j = i; j < stop; ++j)
+			dst[j - offset] = static_cast<float>(v[j]) * scale;
+		i = stop;
+	}
+}
+
+/**
+ * \brief   quantize a carray to int8 with per block scales
+ * Scales come from the finite values of a block. NaN quantizes to 0 and
+ * infinities saturate to +-127.
+ * \param   src     source carray of float, float16 or bfloat16
+ * \param   dst     quantized carray of the same shape
+ * \param   threads number of threads
+ */
+template<class T, size_t N, size_t A, size_t Ab, size_t B>
+void
+quantize(carray<T, N, A>& src, cquant8<N, Ab, B>& dst, size_t threads = default_threads())
+{
+	for (size_t d = 0; d < N; ++d)
+		if (src.shape(d) != dst.shape(d))
+			throw std::invalid_argument("quantize: source and destination shapes differ");
+
+	size_t n = src.size();
+	const T* s = src.begin();
+	int8_t* q = dst.values().begin();
+	float* scales = dst.scales().begin();
+
+	parallel_for(0, dst.blocks(), [&](size_t first, size_t last)
+	{
+		alignas(64) float tmp[B];
+		for (size_t b = first; b < last; ++b)
+		{
+			size_t len = std::min(B, n - b * B);
+			convert_n(s + b * B, tmp, len);
+
+			float scale = absmax(tmp, len) / 127.f;
+			float inv = (scale > 0.f) ? 1.f / scale : 0.f;
+			scales[b] = scale;
+
+			int8_t* out = q + b * B;
+			for (size_t i = 0; i < len; ++i)
+			{
+				float t = tmp[i];
+				float v = std::isnan(t) ? 0.f : std::isinf(t) ? std::copysign(127.f, t) : std::clamp(t * inv, -127.f, 127.f);
+				out[i] = static_cast<int8_t>(static_cast<int>(v + (v >= 0.f ? 0.5f : -0.5f)));
+			}
+		}
+	}, threads);
+}
+
+/**
+ * \brief   dequantize an int8 carray with per block scales
+ * \param   src     quantized carray
+ * \param   dst     destination carray of float, float16 or bfloat16 of the same shape
+ * \param   threads number of threads
+ */
+template<class T, size_t N, size_t A, size_t Ab, size_t B>
+void
+dequantize(cquant8<N, A, B>& src, carray<T, N, Ab>& dst, size_t threads = default_threads())
+{
+	for (size_t d = 0; d < N; ++d)
+		if (src.shape(d) != dst.shape(d))
+			throw std::invalid_argument("dequantize: source and destination shapes differ");
+
+	size_t n = src.size();
+	T* t = dst.begin();
+
+	parallel_for(0, src.blocks(), [&](size_t first, size_t last)
+	{
+		alignas(64) float tmp[B];
+		for (size_t b = first; b < last; ++b)
+		{
+			size_t len = std::min(B, n - b * B);
+			load_f32(src, b * B, len, tmp);
+			convert_n(tmp, t + b * B, len);
+		}
+	}, threads);
+}
+
+/**
+ * \brief   stream a carray or cquant8 through fp32 blocks without converting the whole array.
+ * f is called as f(const float* block, size_t offset, size_t len) for consecutive blocks.
+ * \param   src     source array
+ * \param   f       block kernel
+ */
+template<class Src, class F>
+void
+for_each_f32(const Src& src, F&& f)
+{
+	alignas(64) float tmp[f32_block];
+	size_t n = src.size();
+	for (size_t i = 0; i < n; i += f32_block)
+	{
+		size_t len = std::min(f32_block, n - i);
+		load_f32(src, i, len, tmp);
+		f(static_cast<const float*>(tmp), i, len);
+	}
+}
+
+/**
+ * \brief   dot product of two arrays of any storage precision, computed in fp32 blocks
+ * \param   a       first carray or cquant8
+ * \param   b       second carray or cquant8 with the same number of elements
+ * \returns sum of a[i] * b[i] accumulated in float
+ */
+template<class Sa, class Sb>
+float
+dot(const Sa& a, const Sb& b)
+{
+	if (a.size() != b.size())
+		throw std::invalid_argument("dot: arrays differ in size");
+
+	alignas(64) float tb[f32_block];
+	float acc[16] = {};
+
+	for_each_f32(a, [&](const float* ta, size_t offset, size_t len){
+		load_f32(b, offset, len, tb);
+		size_t i = 0;
+		for (; i + 16 <= len; i += 16)
+			for (size_t l = 0; l < 16; ++l)
+				acc[l] += ta[i + l] * tb[i + l];
+		for (; i < len; ++i)
+			acc[0] += ta[i] * tb[i];
+	});
+
+	return std::accumulate(acc, acc + 16, 0.f);
+}
+
+#endif//__PRECISION_H__
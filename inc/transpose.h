@@ -0,0 +1,361 @@
+#ifndef __TRANSPOSE_H__
+#define __TRANSPOSE_H__
+
+// Copyright (c) 2025  Constantine Papakonstantinou
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/**
+ * \file transpose.h header only support for cache blocked transposes and axis permutations of carrays
+ * \author cpapakonstantinou
+ * \date 2025
+ **/
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+#include <immintrin.h>
+#include <carray.h>
+#include <parallel.h>
+
+/**
+ * \brief   scalar transpose of a rows x cols tile
+ * \param   src     source tile
+ * \param   lds     row stride of the source
+ * \param   dst     destination tile
+ * \param   ldd     row stride of the destination
+ * \param   rows    rows of the source tile
+ * \param   cols    columns of the source tile
+ */
+template<class T>
+static inline void
+transpose_scalar(const T* src, size_t lds, T* dst, size_t ldd, size_t rows, size_t cols)
+{
+	for (size_t i = 0; i < rows; ++i)
+		for (size_t j = 0; j < cols; ++j)
+			dst[j * ldd + i] = src[i * lds + j];
+}
+
+/**
+*	\brief	register level micro transpose of a width x width tile.
+*	The generic kernel is a fixed size scalar loop the compiler can unroll.
+*	float and double are specialized with SIMD shuffles when the target supports them.
+*/
+template<class T>
+struct transpose_micro
+{
+	static constexpr size_t width = 8;
+
+	static inline void
+	kernel(const T* src, size_t lds, T* dst, size_t ldd)
+	{
+		transpose_scalar(src, lds, dst, ldd, width, width);
+	}
+};
+
+#if defined(__AVX__)
+/// 8x8 float micro transpose with AVX unpack/shuffle/permute
+template<>
+struct transpose_micro<float>
+{
+	static constexpr size_t width = 8;
+
+	static inline void
+	kernel(const float* src, size_t lds, float* dst, size_t ldd)
+	{
+		__m256 r0 = _mm256_loadu_ps(src + 0 * lds), r1 = _mm256_loadu_ps(src + 1 * lds);
+		__m256 r2 = _mm256_loadu_ps(src + 2 * lds), r3 = _mm256_loadu_ps(src + 3 * lds);
+		__m256 r4 = _mm256_loadu_ps(src + 4 * lds), r5 = _mm256_loadu_ps(src + 5 * lds);
+		__m256 r6 = _mm256_loadu_ps(src + 6 * lds), r7 = _mm256_loadu_ps(src + 7 * lds);
+
+		__m256 t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpackhi_ps(r0, r1);
+		__m256 t2 = _mm256_unpacklo_ps(r2, r3), t3 = _mm256_unpackhi_ps(r2, r3);
+		__m256 t4 = _mm256_unpacklo_ps(r4, r5), t5 = _mm256_unpackhi_ps(r4, r5);
+		__m256 t6 = _mm256_unpacklo_ps(r6, r7), t7 = _mm256_unpackhi_ps(r6, r7);
+
+		__m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+		_mm256_storeu_ps(dst + 0 * ldd, _mm256_permute2f128_ps(s0, s4, 0x20));
+		_mm256_storeu_ps(dst + 1 * ldd, _mm256_permute2f128_ps(s1, s5, 0x20));
+		_mm256_storeu_ps(dst + 2 * ldd, _mm256_permute2f128_ps(s2, s6, 0x20));
+		_mm256_storeu_ps(dst + 3 * ldd, _mm256_permute2f128_ps(s3, s7, 0x20));
+		_mm256_storeu_ps(dst + 4 * ldd, _mm256_permute2f128_ps(s0, s4, 0x31));
+		_mm256_storeu_ps(dst + 5 * ldd, _mm256_permute2f128_ps(s1, s5, 0x31));
+		_mm256_storeu_ps(dst + 6 * ldd, _mm256_permute2f128_ps(s2, s6, 0x31));
+		_mm256_storeu_ps(dst + 7 * ldd, _mm256_permute2f128_ps(s3, s7, 0x31));
+	}
+};
+
+/// 4x4 double micro transpose with AVX unpack/permute
+template<>
+struct transpose_micro<double>
+{
+	static constexpr size_t width = 4;
+
+	static inline void
+	kernel(const double* src, size_t lds, double* dst, size_t ldd)
+	{
+		__m256d r0 = _mm256_loadu_pd(src + 0 * lds), r1 = _mm256_loadu_pd(src + 1 * lds);
+		__m256d r2 = _mm256_loadu_pd(src + 2 * lds), r3 = _mm256_loadu_pd(src + 3 * lds);
+
+		__m256d t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1);
+		__m256d t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+
+		_mm256_storeu_pd(dst + 0 * ldd, _mm256_permute2f128_pd(t0, t2, 0x20));
+		_mm256_storeu_pd(dst + 1 * ldd, _mm256_permute2f128_pd(t1, t3, 0x20));
+		_mm256_storeu_pd(dst + 2 * ldd, _mm256_permute2f128_pd(t0, t2, 0x31));
+		_mm256_storeu_pd(dst + 3 * ldd, _mm256_permute2f128_pd(t1, t3, 0x31));
+	}
+};
+#elif defined(__SSE__)
+/// 4x4 float micro transpose with SSE
+template<>
+struct transpose_micro<float>
+{
+	static constexpr size_t width = 4;
+
+	static inline void
+	kernel(const float* src, size_t lds, float* dst, size_t ldd)
+	{
+		__m128 r0 = _mm_loadu_ps(src + 0 * lds), r1 = _mm_loadu_ps(src + 1 * lds);
+		__m128 r2 = _mm_loadu_ps(src + 2 * lds), r3 = _mm_loadu_ps(src + 3 * lds);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(dst + 0 * ldd, r0);
+		_mm_storeu_ps(dst + 1 * ldd, r1);
+		_mm_storeu_ps(dst + 2 * ldd, r2);
+		_mm_storeu_ps(dst + 3 * ldd, r3);
+	}
+};
+#endif
+
+/// edge length of a cache tile, tile rows span 256 bytes (at most 128 elements) rounded to the micro width
+template<class T>
+constexpr size_t transpose_block = std::max<size_t>(transpose_micro<T>::width, 
+	(std::min<size_t>(128, 256 / sizeof(T)) / transpose_micro<T>::width) * transpose_micro<T>::width);
+
+/**
+ * \brief   transpose a rows x cols tile using micro transposes, scalar code handles the ragged edges
+ * \param   src     source tile
+ * \param   lds     row stride of the source
+ * \param   dst     destination tile
+ * \param   ldd     row stride of the destination
+ * \param   rows    rows of the source tile
+ * \param   cols    columns of the source tile
+ */
+template<class T>
+static inline void
+transpose_tile(const T* src, size_t lds, T* dst, size_t ldd, size_t rows, size_t cols)
+{
+	constexpr size_t W = transpose_micro<T>::width;
+	size_t iend = rows - rows % W, jend = cols - cols % W;
+
+	for (size_t i = 0; i < iend; i += W)
+	{
+		for (size_t j = 0; j < jend; j += W)
+			transpose_micro<T>::kernel(src + i * lds + j, lds, dst + j * ldd + i, ldd);
+		transpose_scalar(src + i * lds + jend, lds, dst + jend * ldd + i, ldd, W, cols - jend);
+	}
+	transpose_scalar(src + iend * lds, lds, dst + iend, ldd, rows - iend, cols);
+}
+
+/**
+ * \brief   out-of-place transpose of a batch of strided rows x cols matrices.
+ * The batch is split into cache tiles which are distributed over threads.
+ * \param   src     first source matrix
+ * \param   lds     row stride of the source
+ * \param   sbs     stride between source matrices of the batch
+ * \param   dst     first destination matrix
+ * \param   ldd     row stride of the destination
+ * \param   dbs     stride between destination matrices of the batch
+ * \param   batch   number of matrices
+ * \param   rows    rows of each source matrix
+ * \param   cols    columns of each source matrix
+ * \param   threads number of threads
+ */
+template<class T>
+void
+transpose_batched(const T* src, size_t lds, size_t sbs, T* dst, size_t ldd, size_t dbs,
+	size_t batch, size_t rows, size_t cols, size_t threads = default_threads())
+{
+	constexpr size_t B = transpose_block<T>;
+	size_t nbr = (rows + B - 1) / B, nbc = (cols + B - 1) / B;
+
+	parallel_for(0, batch * nbr * nbc, [&](size_t first, size_t last)
+	{
+		for (size_t t = first; t < last; ++t)
+		{
+			size_t b = t / (nbr * nbc), i = (t / nbc) % nbr * B, j = t % nbc * B;
+			transpose_tile(src + b * sbs + i * lds + j, lds, dst + b * dbs + j * ldd + i, ldd,
+				std::min(B, rows - i), std::min(B, cols - j));
+		}
+	}, threads);
+}
+
+/**
+ * \brief   swap the micro tile at (i, j) of a square n x n matrix with the transpose of its mirror at (j, i).
+ * For i == j the micro tile is transposed in place.
+ */
+template<class T>
+static inline void
+transpose_swap_micro(T* p, size_t n, size_t i, size_t j)
+{
+	constexpr size_t W = transpose_micro<T>::width;
+	alignas(64) T tmp[W * W];
+
+	transpose_micro<T>::kernel(p + i * n + j, n, tmp, W);
+	if (i != j)
+		transpose_micro<T>::kernel(p + j * n + i, n, p + i * n + j, n);
+	for (size_t r = 0; r < W; ++r)
+		std::copy(tmp + r * W, tmp + (r + 1) * W, p + (j + r) * n + i);
+}
+
+/**
+ * \brief   in-place transpose of the cache tile [i0, i1) x [j0, j1) of a square n x n matrix and its mirror.
+ * Tiles on the diagonal (i0 == j0) are transposed in place.
+ */
+template<class T>
+static inline void
+transpose_swap_tile(T* p, size_t n, size_t i0, size_t i1, size_t j0, size_t j1)
+{
+	constexpr size_t W = transpose_micro<T>::width;
+	bool diagonal = (i0 == j0);
+	size_t iend = i1 - (i1 - i0) % W, jend = j1 - (j1 - j0) % W;
+
+	for (size_t i = i0; i < iend; i += W)
+		for (size_t j = diagonal ? i : j0; j < jend; j += W)
+			transpose_swap_micro(p, n, i, j);
+
+	for (size_t i = i0; i < i1; ++i)
+		for (size_t j = (i < iend) ? jend : (diagonal ? i + 1 : j0); j < j1; ++j)
+			std::swap(p[i * n + j], p[j * n + i]);
+}
+
+/**
+ * \brief   in-place transpose of a square carray matrix.
+ * Pairs of mirrored cache tiles are swapped, tile rows are interleaved from both ends
+ * of the triangle so each thread receives a similar amount of work.
+ * \param   a       square matrix
+ * \param   threads number of threads
+ */
+template<class T, size_t A>
+void
+transpose(carray<T, 2, A>& a, size_t threads = default_threads())
+{
+	if (a.shape(0) != a.shape(1))
+		throw std::invalid_argument("transpose: in-place transpose requires a square carray");
+
+	constexpr size_t B = transpose_block<T>;
+	T* p = a.begin();
+	size_t n = a.shape(0), nb = (n + B - 1) / B;
+
+	parallel_for(0, nb, [&](size_t first, size_t last)
+	{
+		for (size_t t = first; t < last; ++t)
+		{
+			size_t ib = (t % 2 == 0) ? t / 2 : nb - 1 - t / 2;
+			size_t i0 = ib * B, i1 = std::min(n, i0 + B);
+			for (size_t j0 = i0; j0 < n; j0 += B)
+				transpose_swap_tile(p, n, i0, i1, j0, std::min(n, j0 + B));
+		}
+	}, threads);
+}
+
+/**
+ * \brief   out-of-place transpose b = a^T of a carray matrix
+ * \param   a       source matrix of shape (rows, cols)
+ * \param   b       destination matrix of shape (cols, rows)
+ * \param   threads number of threads
+ */
+template<class T, size_t A, size_t Ab>
+void
+transpose(carray<T, 2, A>& a, carray<T, 2, Ab>& b, size_t threads = default_threads())
+{
+	if (b.shape(0) != a.shape(1) || b.shape(1) != a.shape(0))
+		throw std::invalid_argument("transpose: destination shape does not match transposed source");
+
+	if (static_cast<const void*>(a.begin()) == static_cast<const void*>(b.begin()))
+		return transpose(a, threads);
+
+	transpose_batched<T>(a.begin(), a.shape(1), 0, b.begin(), b.shape(1), 0, 1, a.shape(0), a.shape(1), threads);
+}
+
+/**
+ * \brief   out-of-place axis permutation of a carray tensor, b(i[axes[0]], i[axes[1]], i[axes[2]]) = a(i[0], i[1], i[2]).
+ * Every permutation is reduced to contiguous row copies or a batch of strided 2D transposes.
+ * \param   a       source tensor
+ * \param   b       destination tensor, b.shape(k) == a.shape(axes[k])
+ * \param   axes    permutation of {0, 1, 2}
+ * \param   threads number of threads
+ */
+template<class T, size_t A, size_t Ab>
+void
+permute(carray<T, 3, A>& a, carray<T, 3, Ab>& b, const std::array<size_t, 3>& axes, size_t threads = default_threads())
+{
+	std::array<size_t, 3> sorted = axes;
+	std::sort(sorted.begin(), sorted.end());
+	if (sorted != std::array<size_t, 3>{0, 1, 2})
+		throw std::invalid_argument("permute: axes must be a permutation of {0, 1, 2}");
+
+	for (size_t k = 0; k < 3; ++k)
+		if (b.shape(k) != a.shape(axes[k]))
+			throw std::invalid_argument("permute: destination shape does not match permuted source");
+
+	if (static_cast<const void*>(a.begin()) == static_cast<const void*>(b.begin()))
+		throw std::invalid_argument("permute: source and destination must not share a buffer");
+
+	const T* s = a.begin();
+	T* d = b.begin();
+	size_t n0 = a.shape(0), n1 = a.shape(1), n2 = a.shape(2);
+
+	switch (axes[0] * 100 + axes[1] * 10 + axes[2])
+	{
+		case 12: // (0, 1, 2)
+			parallel_for(0, n0 * n1, [&](size_t first, size_t last){
+				std::copy(s + first * n2, s + last * n2, d + first * n2);
+			}, threads);
+			break;
+		case 102: // (1, 0, 2)
+			parallel_for(0, n1, [&](size_t first, size_t last){
+				for (size_t i1 = first; i1 < last; ++i1)
+					for (size_t i0 = 0; i0 < n0; ++i0)
+						std::copy(s + (i0 * n1 + i1) * n2, s + (i0 * n1 + i1 + 1) * n2, d + (i1 * n0 + i0) * n2);
+			}, threads);
+			break;
+		case 21: // (0, 2, 1)
+			transpose_batched(s, n2, n1 * n2, d, n1, n1 * n2, n0, n1, n2, threads);
+			break;
+		case 201: // (2, 0, 1)
+			transpose_batched(s, n2, 0, d, n0 * n1, 0, 1, n0 * n1, n2, threads);
+			break;
+		case 120: // (1, 2, 0)
+			transpose_batched(s, n1 * n2, 0, d, n0, 0, 1, n0, n1 * n2, threads);
+			break;
+		case 210: // (2, 1, 0)
+			transpose_batched(s, n1 * n2, n2, d, n1 * n0, n0, n1, n0, n2, threads);
+			break;
+	}
+}
+
+#endif//__TRANSPOSE_H__
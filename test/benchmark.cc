@@ -28,9 +28,11 @@
 #include <iostream>
 #include <vector>
 #include <chrono>
+#include <cstring>
 #include <boost/multi_array.hpp>
 #include <Eigen/Dense>
 #include "carray.h"
+#include "gemm.h"
 
 #ifndef N_ARRAY
 	#define N_ARRAY 4096
@@ -40,7 +42,12 @@
 	#define N_REPEAT 3
 #endif
 
+#ifndef N_GEMM
+	#define N_GEMM 1024
+#endif
+
 constexpr const int n = static_cast<int>(N_ARRAY);
+constexpr const int n_gemm = static_cast<int>(N_GEMM);
 constexpr const int repeat = static_cast<int>(N_REPEAT);
 
 /**
@@ -202,6 +209,112 @@ test_std_vector(int repeat)
 	return d;
 }
 
+double
+test_gemm_carray(int repeat, size_t threads)
+{
+	carray<float, 2, 64> a(n_gemm, n_gemm), b(n_gemm, n_gemm), c(n_gemm, n_gemm);
+	double d = 0;
+	for (int i = 0; i < n_gemm; ++i)
+		for (int j = 0; j < n_gemm; ++j)
+		{
+			a[i][j] = static_cast<float>((i + j) % 7);
+			b[i][j] = static_cast<float>((i * j) % 5);
+		}
+	while(repeat--)
+	{
+		gemm(a, b, c, 1.f, 0.f, threads);
+		pass(&c[0][0], &a[0][0], repeat);
+		for (int i = 0; i < n_gemm; ++i)
+			for (int j = 0; j < n_gemm; ++j)
+				d += c[i][j];
+	}
+	return d;
+}
+
+double
+test_gemm_eigen(int repeat)
+{
+	Eigen::MatrixXf a(n_gemm, n_gemm), b(n_gemm, n_gemm), c(n_gemm, n_gemm);
+	double d = 0;
+	for (int i = 0; i < n_gemm; ++i)
+		for (int j = 0; j < n_gemm; ++j)
+		{
+			a(i, j) = static_cast<float>((i + j) % 7);
+			b(i, j) = static_cast<float>((i * j) % 5);
+		}
+	while(repeat--)
+	{
+		c.noalias() = a * b;
+		pass(&(c(0, 0)), &(a(0, 0)), repeat);
+		for (int i = 0; i < n_gemm; ++i)
+			for (int j = 0; j < n_gemm; ++j)
+				d += c(i, j);
+	}
+	return d;
+}
+
+/// first use touches one element, full use accumulates into every element
+double
+first_use(carray<float, 2, 64>& a, int repeat)
+{
+	a[repeat % n][repeat % n] += 1;
+	return a(repeat % n, repeat % n) + a(n - 1, n - 1);
+}
+
+double
+full_use(carray<float, 2, 64>& a, int repeat)
+{
+	double d = 0;
+	for (int i = 0; i < n; ++i)
+		for (int j = 0; j < n; ++j)
+			a[i][j] += static_cast<float>(j + repeat);
+	pass(&a[0][0], &a[0][0], repeat);
+	for (int i = 0; i < n; ++i)
+		for (int j = 0; j < n; ++j)
+			d += a[i][j];
+	return d;
+}
+
+template<class Use>
+double
+test_init_memset(int repeat, Use use)
+{
+	double d = 0;
+	while(repeat--)
+	{
+		carray<float, 2, 64> a(n, n);
+		std::memset(a.begin(), 0, a.size() * sizeof(float));
+		d += use(a, repeat);
+	}
+	return d;
+}
+
+template<class Use>
+double
+test_init_zeroed(int repeat, Use use)
+{
+	double d = 0;
+	while(repeat--)
+	{
+		carray<float, 2, 64> a(carray_zeroed, n, n);
+		d += use(a, repeat);
+	}
+	return d;
+}
+
+template<class Use>
+double
+test_init_fill(int repeat, Use use)
+{
+	double d = 0;
+	while(repeat--)
+	{
+		carray<float, 2, 64> a(carray_fill, 0.f, n, n);
+		d += use(a, repeat);
+	}
+	return d;
+}
+
 int main(int argc, char* argv[]) 
 {
 	std::cout << "Benchmarking different 2D array representations:\n";
@@ -233,6 +346,59 @@ int main(int argc, char* argv[])
 		}
 
 	}
-	
+
+	// Eigen runs single threaded without -fopenmp, compare against a single threaded gemm
+	std::cout << "Benchmarking " << n_gemm << "x" << n_gemm << " float matrix products:\n";
+
+	Benchmark products[] =
+	{
+		{"carray gemm (1 thread)", [](int r){ return test_gemm_carray(r, 1); }},
+		{"Eigen (1 thread)", test_gemm_eigen},
+		{"carray gemm (default_threads: " + std::to_string(default_threads()) + ")", [](int r){ return test_gemm_carray(r, default_threads()); }}
+	};
+
+	double reference = 0;
+	for (const auto& bench : products)
+	{
+		double output = 0;
+		double time = dispatch(bench.func, repeat, output);
+		double gflops = 2e-9 * n_gemm * n_gemm * static_cast<double>(n_gemm) * repeat / time;
+		std::cout << bench.name << ": " << time << " seconds, " << gflops << " GFLOP/s\n";
+		if (reference == 0)
+			reference = output;
+		else if (fabs(1-output/reference) >= 1e-6)
+			std::cerr << bench.name << " does not produce the same result as carray gemm" << std::endl;
+	}
+
+	std::cout << "Benchmarking time to first use of zero initialized " << n << "x" << n << " float arrays:\n";
+
+	struct Initialization
+	{
+		std::string name;
+		std::function<double(int)> first;
+		std::function<double(int)> full;
+	} initializations[] =
+	{
+		{"memset", [](int r){ return test_init_memset(r, first_use); }, [](int r){ return test_init_memset(r, full_use); }},
+		{"carray_zeroed", [](int r){ return test_init_zeroed(r, first_use); }, [](int r){ return test_init_zeroed(r, full_use); }},
+		{"carray_fill", [](int r){ return test_init_fill(r, first_use); }, [](int r){ return test_init_fill(r, full_use); }}
+	};
+
+	double first_reference = 0, full_reference = 0;
+	for (const auto& init : initializations)
+	{
+		double first = 0, full = 0;
+		double first_time = dispatch(init.first, repeat, first);
+		double full_time = dispatch(init.full, repeat, full);
+		std::cout << init.name << ": first use " << first_time << " seconds, full use " << full_time << " seconds\n";
+		if (first_reference == 0)
+		{
+			first_reference = first;
+			full_reference = full;
+		}
+		else if (first != first_reference || fabs(1-full/full_reference) >= 1e-6)
+			std::cerr << init.name << " does not produce the same result as memset" << std::endl;
+	}
+
 	return 0;
 }
\ No newline at end of file
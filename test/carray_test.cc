@@ -4,6 +4,15 @@
 #include <exception>
 #include <assert.h>
 #include <carray.h>
+#include <transpose.h>
+#include <gemm.h>
+#include <cbatch.h>
+#include <csoa.h>
+#include <precision.h>
+#include <cshared.h>
+#include <chalo.h>
+#include <cstream.h>
+#include <sys/wait.h>
 
 #define VERBOSE 0 
 
@@ -187,6 +196,620 @@ view_test()
 
 }
 
+std::tuple<bool, bool>
+parallel_test()
+{
+	bool c = true, e = true;
+
+	std::vector<int> hits(1000, 0);
+	parallel_for(0, hits.size(), [&](size_t first, size_t last){
+		for (size_t i = first; i < last; i++)
+			hits[i]++;
+	}, 4);
+	c = std::all_of(hits.begin(), hits.end(), [](int h){ return h == 1; });
+
+	// a throwing worker chunk and a throwing calling thread chunk both propagate
+	for (size_t bad : {0, 3})
+	{
+		try
+		{
+			parallel_for(0, 4, [bad](size_t first, size_t){
+				if (first == bad)
+					throw std::runtime_error("parallel_for chunk");
+			}, 4);
+			e = false;
+		}
+		catch (const std::runtime_error&) {}
+	}
+
+	return std::make_tuple(c, e);
+}
+
+std::tuple<bool, bool, bool>
+transpose_test()
+{
+	bool o = true, i = true, p = true;
+
+	size_t rows = 131, cols = 77, n = 150;
+
+	cmatrix<float> a(rows, cols), b(cols, rows);
+	for (size_t r = 0; r < rows; r++)
+		for (size_t c = 0; c < cols; c++)
+			a[r][c] = static_cast<float>(r * cols + c);
+
+	transpose(a, b, 3);
+
+	for (size_t r = 0; r < rows; r++)
+		for (size_t c = 0; c < cols; c++)
+			o &= (b(c, r) == a(r, c));
+
+	cmatrix<double> s(n, n);
+	for (size_t r = 0; r < n; r++)
+		for (size_t c = 0; c < n; c++)
+			s[r][c] = static_cast<double>(r * n + c);
+
+	transpose(s, 3);
+
+	for (size_t r = 0; r < n; r++)
+		for (size_t c = 0; c < n; c++)
+			i &= (s(r, c) == static_cast<double>(c * n + r));
+
+	size_t shape[] = {13, 21, 34};
+	ctensor<uint16_t> t(shape[0], shape[1], shape[2]);
+	for (size_t x = 0; x < shape[0]; x++)
+		for (size_t y = 0; y < shape[1]; y++)
+			for (size_t z = 0; z < shape[2]; z++)
+				t[x][y][z] = static_cast<uint16_t>((x * shape[1] + y) * shape[2] + z);
+
+	std::array<size_t, 3> perms[] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+	for (auto& axes : perms)
+	{
+		ctensor<uint16_t> u(shape[axes[0]], shape[axes[1]], shape[axes[2]]);
+		permute(t, u, axes, 2);
+
+		for (size_t x = 0; x < shape[0]; x++)
+			for (size_t y = 0; y < shape[1]; y++)
+				for (size_t z = 0; z < shape[2]; z++)
+				{
+					size_t idx[] = {x, y, z};
+					p &= (u(idx[axes[0]], idx[axes[1]], idx[axes[2]]) == t(x, y, z));
+				}
+	}
+
+	return std::make_tuple(o, i, p);
+}
+
+template<class T>
+bool
+gemm_check(size_t m, size_t n, size_t k, T alpha, T beta)
+{
+	bool g = true;
+
+	carray<T, 2, 64> a(m, k), b(k, n), c(m, n), d(m, n);
+	for (size_t i = 0; i < m; i++)
+		for (size_t p = 0; p < k; p++)
+			a[i][p] = static_cast<T>((i * 7 + p * 3) % 11) - 5;
+	for (size_t p = 0; p < k; p++)
+		for (size_t j = 0; j < n; j++)
+			b[p][j] = static_cast<T>((p * 5 + j) % 13) - 6;
+	for (size_t i = 0; i < m; i++)
+		for (size_t j = 0; j < n; j++)
+			c[i][j] = d[i][j] = static_cast<T>(i + j);
+
+	gemm(a, b, c, alpha, beta, 3);
+
+	for (size_t i = 0; i < m; i++)
+		for (size_t j = 0; j < n; j++)
+		{
+			T s = 0;
+			for (size_t p = 0; p < k; p++)
+				s += a(i, p) * b(p, j);
+			g &= (c(i, j) == alpha * s + beta * d(i, j));
+		}
+
+	return g;
+}
+
+std::tuple<bool, bool>
+gemm_test()
+{
+	bool f = gemm_check<float>(37, 53, 300, 1.0f, 0.0f) & gemm_check<float>(130, 17, 5, 2.0f, 1.0f);
+	bool d = gemm_check<double>(129, 70, 513, 2.0, 3.0) & gemm_check<double>(1, 1, 1, 1.0, 0.0);
+
+	return std::make_tuple(f, d);
+}
+
+std::tuple<bool, bool, bool, bool>
+batch_test()
+{
+	bool mm = true, lu = true, ch = true, dt = true;
+
+	size_t batch = 37, n = 5, nrhs = 2;
+
+	cbatch<double> a(batch, n, n), at(batch, n, n), s(batch, n, n);
+	cbatch<double> x(batch, n, nrhs), y(batch, n, nrhs), rhs(batch, n, nrhs);
+
+	for (size_t b = 0; b < batch; b++)
+		for (size_t i = 0; i < n; i++)
+		{
+			for (size_t j = 0; j < n; j++)
+				a.batch(b)(i, j) = at.batch(b)(j, i) = static_cast<double>((b * 3 + i * 7 + j * 5) % 11) - 5.5
+					+ (j == (i + b) % n ? 20 : 0); // dominant entries off the diagonal force pivoting
+			for (size_t c = 0; c < nrhs; c++)
+				x(b, i, c) = y(b, i, c) = rhs(b, i, c) = static_cast<double>(i + c + b % 3);
+		}
+
+	// s = a * a^T + n * I is symmetric positive definite
+	batch_matmul(a, at, s, 2);
+	for (size_t b = 0; b < batch; b++)
+		for (size_t i = 0; i < n; i++)
+		{
+			for (size_t j = 0; j < n; j++)
+			{
+				double r = 0;
+				for (size_t k = 0; k < n; k++)
+					r += a(b, i, k) * a(b, j, k);
+				mm &= (s(b, i, j) == r);
+			}
+			s(b, i, i) += n;
+		}
+
+	batch_lu_solve(a, x, 2);
+	batch_cholesky_solve(s, y, 2);
+
+	for (size_t b = 0; b < batch; b++)
+		for (size_t i = 0; i < n; i++)
+			for (size_t c = 0; c < nrhs; c++)
+			{
+				double ra = 0, rs = 0;
+				for (size_t j = 0; j < n; j++)
+				{
+					ra += a(b, i, j) * x(b, j, c);
+					rs += s(b, i, j) * y(b, j, c);
+				}
+				lu &= (std::abs(ra - rhs(b, i, c)) < 1e-9);
+				ch &= (std::abs(rs - rhs(b, i, c)) < 1e-9);
+			}
+
+	cbatch<double> d(3, 2, 2);
+	double values[3][4] = {{1, 2, 3, 4}, {0, 1, 1, 0}, {1, 2, 2, 4}};
+	for (size_t b = 0; b < 3; b++)
+		for (size_t k = 0; k < 4; k++)
+			d(b, k / 2, k % 2) = values[b][k];
+
+	carray<double, 1, 64> det(3);
+	batch_det(d, det);
+	dt = (det(0) == -2) & (det(1) == -1) & (det(2) == 0);
+
+	return std::make_tuple(mm, lu, ch, dt);
+}
+
+template<template<class> class F>
+struct particle
+{
+	F<float> x, y, z;
+	F<double> m;
+	F<uint8_t> tag;
+	auto tie() { return std::tie(x, y, z, m, tag); }
+};
+
+std::tuple<bool, bool, bool, bool>
+soa_test()
+{
+	bool a = true, r = true, f = true, v = true;
+
+	size_t rows = 13, cols = 7, n = rows * cols;
+
+	csoa<particle, 2, 64> p(rows, cols);
+
+	auto ptr = p.data();
+	std::apply([&a](auto... q){ ((a &= ((uintptr_t)q % 64 == 0)), ...); }, ptr.tie());
+	a &= ((uintptr_t)ptr.m - (uintptr_t)ptr.x == 3 * ((n * sizeof(float) + 63) / 64 * 64));
+
+	for (size_t i = 0; i < rows; i++)
+		for (size_t j = 0; j < cols; j++)
+		{
+			p(i, j).x = static_cast<float>(i);
+			p(i, j).y = static_cast<float>(j);
+			p(i, j).z = 0;
+			p(i, j).m = static_cast<double>(i * cols + j);
+			p(i, j).tag = static_cast<uint8_t>(j);
+		}
+
+	for (size_t i = 0; i < rows; i++)
+		for (size_t j = 0; j < cols; j++)
+			r &= (&p[i * cols + j].m == &p(i, j).m) & (ptr.x[i * cols + j] == i) & (ptr.tag[i * cols + j] == j);
+
+	auto c = p.columns();
+	for (size_t i = 0; i < n; i++)
+		c.z[i] = c.x[i] + c.y[i];
+	double sum = 0;
+	for (double m : p.field<3>())
+		sum += m;
+	for (size_t i = 0; i < rows; i++)
+		for (size_t j = 0; j < cols; j++)
+			f &= (p(i, j).z == static_cast<float>(i + j));
+	f &= (sum == static_cast<double>(n * (n - 1) / 2));
+
+	particle<soa_value> q = p.get(5);
+	q.m = -1;
+	p.set(6, q);
+	v = (p[6].m == -1) & (p[6].x == p[5].x) & (p[5].m == 5) & (p[6].tag == p[5].tag);
+
+	return std::make_tuple(a, r, f, v);
+}
+
+std::tuple<bool, bool, bool, bool>
+precision_test()
+{
+	bool h = true, b = true, q = true, d = true;
+
+	size_t rows = 37, cols = 29, n = rows * cols;
+
+	cmatrix<float> x(rows, cols), y(rows, cols);
+	for (size_t i = 0; i < rows; i++)
+		for (size_t j = 0; j < cols; j++)
+			x[i][j] = std::sin(static_cast<float>(i * cols + j)) * static_cast<float>(i + 1);
+
+	cmatrix<float16> xh(rows, cols);
+	convert(x, xh, 2);
+	convert(xh, y, 2);
+	for (size_t i = 0; i < rows; i++)
+		for (size_t j = 0; j < cols; j++)
+			h &= (xh(i, j) == static_cast<float16>(x(i, j))) & (y(i, j) == static_cast<float>(xh(i, j)));
+
+	cmatrix<bfloat16> xb(rows, cols);
+	convert(x, xb, 2);
+	convert(xb, y, 2);
+	for (size_t i = 0; i < rows; i++)
+		for (size_t j = 0; j < cols; j++)
+			b &= (std::abs(y(i, j) - x(i, j)) <= std::abs(x(i, j)) / 256);
+	b &= (static_cast<float>(bfloat16(1.f + 1.f / 256)) == 1.f) & (static_cast<float>(bfloat16(1.f + 3.f / 256)) == 1.f + 4.f / 256);
+
+	cquant8<2, 64, 32> xq(rows, cols);
+	quantize(x, xq, 2);
+	dequantize(xq, y, 2);
+	for (size_t i = 0; i < rows; i++)
+		for (size_t j = 0; j < cols; j++)
+		{
+			float scale = xq.scales()((i * cols + j) / 32);
+			q &= (std::abs(y(i, j) - x(i, j)) <= scale / 2 * 1.0001f) & (y(i, j) == xq(i, j));
+		}
+
+	// non-finite values do not poison their block: NaN is 0, infinities saturate
+	cvector<float> nf(64);
+	for (size_t i = 0; i < 64; i++)
+		nf[i] = static_cast<float>(i) - 20.f;
+	nf[3] = std::numeric_limits<float>::quiet_NaN();
+	nf[5] = std::numeric_limits<float>::infinity();
+	nf[40] = -std::numeric_limits<float>::infinity();
+	cquant8<1, 64, 32> nq(64);
+	quantize(nf, nq, 1);
+	q &= (nq.values()(3) == 0) & (nq.values()(5) == 127) & (nq.values()(40) == -127);
+	q &= (nq.scales()(0) == 20.f / 127) & (nq.scales()(1) == 43.f / 127) & (nq.values()(0) == -127) & (nq.values()(63) == 127);
+
+	float exact = 0, exact_h = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		exact += x.begin()[i] * x.begin()[i];
+		exact_h += static_cast<float>(xh.begin()[i]) * x.begin()[i];
+	}
+	d = (std::abs(dot(xh, x) - exact_h) <= 1e-4f * exact) & (std::abs(dot(xq, xb) - exact) <= 1e-2f * exact);
+
+	return std::make_tuple(h, b, q, d);
+}
+
+std::tuple<bool, bool, bool, bool>
+shared_test()
+{
+	bool a = true, p = true, s = true, r = true;
+
+	std::string name = "/carray_test_" + std::to_string(getpid());
+	size_t rows = 33, cols = 17;
+
+	auto producer = cshared<float, 2, 64>::create(name, rows, cols);
+	auto consumer = cshared<float, 2, 64>::attach(name);
+
+	a = ((uintptr_t)producer.array().begin() % 64 == 0) & ((uintptr_t)consumer.array().begin() % 64 == 0);
+	a &= (consumer.array().shape(0) == rows) & (consumer.array().shape(1) == cols);
+	a &= (consumer.array().get() != producer.array().get());
+
+	producer.write([&](cmatrix<float>& m){
+		for (size_t i = 0; i < rows; i++)
+			for (size_t j = 0; j < cols; j++)
+				m[i][j] = static_cast<float>(i * cols + j);
+	});
+
+	cmatrix<float> frame(rows, cols);
+	uint64_t generation = consumer.read([&](cmatrix<float>& m){ std::copy(m.begin(), m.end(), frame.begin()); });
+	s = (generation == 1);
+	for (size_t i = 0; i < rows; i++)
+		for (size_t j = 0; j < cols; j++)
+			s &= (frame(i, j) == static_cast<float>(i * cols + j));
+
+	producer.begin_write();
+	uint64_t observed;
+	s &= !consumer.try_read([](cmatrix<float>&){}, observed);
+	producer.end_write();
+	s &= consumer.try_read([](cmatrix<float>&){}, observed) & (observed == 2);
+
+	// a separate process attaches by name and publishes a frame
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		auto child = cshared<float, 2, 64>::attach(name);
+		child.write([&](cmatrix<float>& m){ std::fill(m.begin(), m.end(), -1.f); });
+		_exit(0);
+	}
+	int status = -1;
+	waitpid(pid, &status, 0);
+	p = (status == 0) & (producer.generation() == 3) & (producer.array()(rows - 1, cols - 1) == -1.f);
+
+	// replacing the segment leaves attached views untouched, new attachers see the new shape
+	auto replacement = cshared<float, 2, 64>::create(name, 2, 3);
+	auto late = cshared<float, 2, 64>::attach(name);
+	r = (consumer.generation() == 3) & (consumer.array()(rows - 1, cols - 1) == -1.f);
+	r &= (late.array().shape(0) == 2) & (late.array().shape(1) == 3) & (late.generation() == 0);
+
+	cshared<float, 2, 64>::unlink(name);
+
+	return std::make_tuple(a, p, s, r);
+}
+
+std::tuple<bool, bool, bool>
+halo_test()
+{
+	bool a = true, t = true, f = true;
+
+	size_t n0 = 9, n1 = 11, n2 = 37, h = 3, steps = 7;
+
+	auto heat = [](const float* c, ptrdiff_t sj, ptrdiff_t si){
+		return 0.4f * c[0] + 0.1f * ((c[-1] + c[1]) + (c[-sj] + c[sj]) + (c[-si] + c[si]));
+	};
+
+	halo_boundary<float> bcs[] = {
+		{halo_kind::periodic},
+		{halo_kind::dirichlet, 2.f},
+		{halo_kind::copy},
+		{{halo_kind::copy, halo_kind::periodic, halo_kind::dirichlet}, -1.f},
+		{{halo_kind::dirichlet, halo_kind::copy, halo_kind::periodic}, 3.f}
+	};
+
+	for (auto& bc : bcs)
+	{
+		chalo<float, 64> ref(n0, n1, n2, h), tmp(n0, n1, n2, h), tiled(n0, n1, n2, h), fused(n0, n1, n2, h);
+
+		for (size_t i = 0; i < n0; i++)
+			for (size_t j = 0; j < n1; j++)
+			{
+				a &= ((uintptr_t)ref.row(i, j) % 64 == 0);
+				for (size_t k = 0; k < n2; k++)
+					ref(i, j, k) = tiled(i, j, k) = fused(i, j, k) = static_cast<float>((i * 7 + j * 3 + k) % 13);
+			}
+
+		// reference: untiled sweeps through the element operator
+		for (size_t s = 0; s < steps; s++)
+		{
+			ref.fill_halo(bc, 1);
+			for (size_t i = 0; i < n0; i++)
+				for (size_t j = 0; j < n1; j++)
+					for (size_t k = 0; k < n2; k++)
+						tmp(i, j, k) = heat(&ref(i, j, k), ref.stride(1), ref.stride(0));
+			for (size_t i = 0; i < n0; i++)
+				for (size_t j = 0; j < n1; j++)
+					for (size_t k = 0; k < n2; k++)
+						ref(i, j, k) = tmp(i, j, k);
+		}
+
+		stencil(tiled, heat, 1, steps, bc, {{4, 5, 16}, 1, 3});
+		stencil(fused, heat, 1, steps, bc, {{4, 5, 16}, 3, 3});
+
+		for (size_t i = 0; i < n0; i++)
+			for (size_t j = 0; j < n1; j++)
+				for (size_t k = 0; k < n2; k++)
+				{
+					t &= (tiled(i, j, k) == ref(i, j, k));
+					f &= (fused(i, j, k) == ref(i, j, k));
+				}
+	}
+
+	return std::make_tuple(a, t, f);
+}
+
+std::tuple<bool, bool, bool, bool>
+stream_test()
+{
+	bool t = true, u = true, r = true, e = true;
+
+	size_t rows = 37, cols = 53, count = 5;
+	std::string prefix = "/tmp/carray_test_" + std::to_string(getpid());
+	std::vector<std::string> paths;
+
+	FILE* frames = fopen((prefix + "_frames").c_str(), "wb");
+	for (size_t i = 0; i < count; i++)
+	{
+		std::vector<float> m(rows * cols);
+		for (size_t x = 0; x < m.size(); x++)
+			m[x] = static_cast<float>(i * 10000 + x);
+		paths.push_back(prefix + "_" + std::to_string(i));
+		FILE* f = fopen(paths.back().c_str(), "wb");
+		fwrite(m.data(), sizeof(float), m.size(), f);
+		fclose(f);
+		fwrite(m.data(), sizeof(float), m.size(), frames);
+	}
+	fclose(frames);
+
+	auto valid = [&](cmatrix<float>& m, size_t i){
+		bool v = (m.shape(0) == rows) & (m.shape(1) == cols);
+		for (size_t x = 0; x < rows; x++)
+			for (size_t y = 0; y < cols; y++)
+				v &= (m[x][y] == static_cast<float>(i * 10000 + x * cols + y));
+		return v;
+	};
+
+	// thread pool, double buffered, chunks that do not divide the rows
+	{
+		cstream<float, 2, 64> s(paths, {rows, cols}, {2, stream_backend::threads, 1000});
+		size_t expect = 0;
+		s.consume([&](cmatrix<float>& m, size_t i){ t &= (i == expect++) & valid(m, i); });
+		t &= (expect == count) & (std::string(s.stats().backend) == "threads");
+	}
+
+	// io_uring where available, triple buffered frames of one file with a shallow ring
+	{
+		stream_options o{3, CSTREAM_URING ? stream_backend::uring : stream_backend::automatic, 4096, 4};
+		cstream<float, 2, 64> s(prefix + "_frames", count, {rows, cols}, o);
+
+		std::vector<float*> seen;
+		size_t i, expect = 0;
+		while (cmatrix<float>* m = s.next(&i))
+		{
+			u &= (i == expect++) & valid(*m, i);
+			r &= ((uintptr_t)m->begin() % 64 == 0);
+			if (std::find(seen.begin(), seen.end(), m->begin()) == seen.end())
+				seen.push_back(m->begin());
+		}
+
+		stream_stats st = s.stats();
+		u &= (expect == count) & (s.next() == nullptr);
+		r &= (seen.size() == s.buffers()) & (s.buffers() == 3);
+		r &= (st.arrays == count) & (st.bytes == count * rows * cols * sizeof(float));
+		r &= (st.max_depth > 0) & (st.mean_depth > 0) & (st.throughput() > 0);
+	}
+
+	// arrays far larger than depth * chunk keep loading while the consumer holds the previous one
+	{
+		stream_options o{2, CSTREAM_URING ? stream_backend::uring : stream_backend::automatic, 512, 2};
+		cstream<float, 2, 64> s(paths, {rows, cols}, o);
+
+		size_t i, expect = 0;
+		while (cmatrix<float>* m = s.next(&i))
+		{
+			u &= (i == expect++) & valid(*m, i);
+			bool ready = s.ready();
+			for (int poll = 0; poll < 1000 && !ready; poll++)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				ready = s.ready();
+			}
+			u &= ready;
+		}
+		u &= (expect == count);
+	}
+
+	// arrays before a failure are delivered, the failure is raised when due and on every later call
+	auto failing = [&](cstream<float, 2, 64>& s, size_t bad){
+		bool v = true;
+		size_t i;
+		for (size_t k = 0; k < bad; k++)
+		{
+			cmatrix<float>* m = s.next(&i);
+			v &= (m != nullptr) && (i == k) && valid(*m, i % count);
+		}
+		for (int call = 0; call < 2; call++)
+		{
+			try
+			{
+				s.next();
+				v = false;
+			}
+			catch (const std::exception&) {}
+		}
+		return v;
+	};
+
+	{
+		cstream<float, 2, 64> s(paths[0], 2, {rows, cols});
+		e &= failing(s, 1);
+	}
+
+	std::vector<std::string> missing = paths;
+	missing[3] = prefix + "_missing";
+	for (auto b : {stream_backend::threads, stream_backend::automatic})
+	{
+		cstream<float, 2, 64> s(missing, {rows, cols}, {2, b});
+		e &= failing(s, 3);
+	}
+
+	for (auto& p : paths)
+		unlink(p.c_str());
+	unlink((prefix + "_frames").c_str());
+
+	return std::make_tuple(t, u, r, e);
+}
+
+/// element counting its live instances, throwing once a construction budget is spent
+struct tracked
+{
+	static inline std::atomic<long> live = 0;
+	static inline std::atomic<long> budget = -1;
+
+	std::string s;
+
+	tracked(): s("default") { take(); }
+	tracked(const tracked& o): s(o.s) { take(); }
+	~tracked() { live--; }
+
+	void take()
+	{
+		if (budget.load() >= 0 && budget-- == 0)
+			throw std::runtime_error("tracked: construction budget spent");
+		live++;
+	}
+};
+
+std::tuple<bool, bool, bool, bool>
+init_test()
+{
+	bool z = true, f = true, l = true, e = true;
+
+	// large enough for mapped zero pages, and small enough for palign
+	{
+		carray<float, 2, 64> big(carray_zeroed, 1024, 1031), small(carray_zeroed, 3, 5);
+		z &= ((uintptr_t)big.begin() % 64 == 0) & ((uintptr_t)small.begin() % 64 == 0);
+		z &= std::all_of(big.begin(), big.end(), [](float x){ return x == 0; });
+		z &= std::all_of(small.begin(), small.end(), [](float x){ return x == 0; });
+		big[1023][1030] = 1;
+		z &= (big(1023, 1030) == 1) & (big(0, 0) == 0);
+
+		carray<float, 1, 64> raw(carray_uninitialized, 17);
+		z &= (raw.size() == 17);
+	}
+
+	{
+		carray<double, 3, 64> d(carray_fill, 2.5, 7, 300, 301);
+		f &= std::all_of(d.begin(), d.end(), [](double x){ return x == 2.5; });
+
+		carray<std::string, 2, 64> s(carray_fill, std::string("carray"), 5, 9);
+		f &= std::all_of(s.begin(), s.end(), [](const std::string& x){ return x == "carray"; });
+	}
+
+	{
+		tracked proto;
+		proto.s = "fill";
+		{
+			carray<tracked, 2, 64> a(300, 700), b(carray_zeroed, 3, 4), c(carray_fill, proto, 11, 13);
+			l &= (tracked::live == 1 + 300 * 700 + 3 * 4 + 11 * 13);
+			l &= (a(299, 699).s == "default") & (b(2, 3).s == "default") & (c(10, 12).s == "fill");
+
+			carray<tracked, 2, 64> shared = a;
+		}
+		l &= (tracked::live == 1);
+	}
+
+	tracked::budget = 100000;
+	try
+	{
+		carray<tracked, 1, 64> a(300000);
+		e = false;
+	}
+	catch (const std::runtime_error&) {}
+	tracked::budget = -1;
+	e &= (tracked::live == 0);
+
+	return std::make_tuple(z, f, l, e);
+}
+
 int main(int argc, char* argv[])
 {
 	try
@@ -212,6 +835,36 @@ int main(int argc, char* argv[])
 		auto [r1, r2, r3, r4] = view_test();
 		printf("[%s] rank1 view\n[%s] rank2 view\n[%s] rank3 view\n[%s] rank4 view\n", status(r1), status(r2), status(r3), status(r4));
 
+		auto [pc, pe] = parallel_test();
+		printf("[%s] parallel_for coverage\n[%s] parallel_for exceptions\n", status(pc), status(pe));
+
+		auto [to, ti, tp] = transpose_test();
+		printf("[%s] out-of-place transpose\n[%s] in-place transpose\n[%s] tensor permute\n", status(to), status(ti), status(tp));
+
+		auto [gf, gd] = gemm_test();
+		printf("[%s] float gemm\n[%s] double gemm\n", status(gf), status(gd));
+
+		auto [bm, bl, bc, bd] = batch_test();
+		printf("[%s] batched matmul\n[%s] batched LU solve\n[%s] batched Cholesky solve\n[%s] batched determinant\n", status(bm), status(bl), status(bc), status(bd));
+
+		auto [sa, sr, sf, sv] = soa_test();
+		printf("[%s] SoA field alignment\n[%s] SoA record access\n[%s] SoA field iteration\n[%s] SoA record values\n", status(sa), status(sr), status(sf), status(sv));
+
+		auto [ph, pb, pq, pd] = precision_test();
+		printf("[%s] fp16 conversion\n[%s] bf16 conversion\n[%s] int8 block quantization\n[%s] reduced precision dot\n", status(ph), status(pb), status(pq), status(pd));
+
+		auto [sha, shp, shs, shr] = shared_test();
+		printf("[%s] shared memory attach\n[%s] shared memory across processes\n[%s] shared memory seqlock\n[%s] shared memory replace\n", status(sha), status(shp), status(shs), status(shr));
+
+		auto [ha, ht, hf] = halo_test();
+		printf("[%s] halo interior alignment\n[%s] tiled stencil\n[%s] temporally blocked stencil\n", status(ha), status(ht), status(hf));
+
+		auto [ct, cu, cr, ce] = stream_test();
+		printf("[%s] threaded stream\n[%s] io_uring stream\n[%s] stream buffer recycling\n[%s] stream failures\n", status(ct), status(cu), status(cr), status(ce));
+
+		auto [iz, ifl, il, ie] = init_test();
+		printf("[%s] zeroed initialization\n[%s] fill initialization\n[%s] non-trivial element lifetimes\n[%s] throwing element construction\n", status(iz), status(ifl), status(il), status(ie));
+
 	}
 	catch(const std::exception& e)
 	{